@@ -0,0 +1,147 @@
+"""
+Scores many positions in parallel with the C engine.
+
+Reads one FEN or EPD record per line from a file (or stdin), and writes one line per position:
+    <fen>\t<best move>\t<score>\t<depth>\t<nodes>\t<milliseconds>
+where the score is from the side to move's perspective, as UCI writes it ("cp 31" or "mate -3").
+A malformed FEN, or a position with no legal move, gets an empty move and 0 for the depth and nodes.
+With --multipv N, each line also gets the top N moves as UCI info lines ("info multipv 1 depth 9 score cp 31 pv ..."),
+tab-separated.
+Positions are streamed through a pool of worker processes, each with its own copy of the engine loaded.
+At most --chunk positions are read ahead of the output, so memory stays bounded for dumps with millions of positions.
+
+Usage: python3 batch_API.py [positions.fen|-] [--workers N] [--chunk N] [--multipv N] [--output results.txt]
+"""
+import argparse
+import ctypes
+import multiprocessing
+import os
+import sys
+import threading
+import time
+
+so_file = sys.path[0] + "/lichess_bot/engines/ChessEngine.so"
+ChessEngine = None  # Loaded once per worker process
+
+MATE_SCORE = 30000  # As in src/search.h
+MAX_PLY = 128
+
+
+class SearchResult(ctypes.Structure):
+    """struct search_result in src/search.h"""
+    _fields_ = [("move", ctypes.c_char * 8), ("score", ctypes.c_int), ("depth", ctypes.c_int),
+                ("nodes", ctypes.c_uint64), ("time", ctypes.c_int64)]
+
+
+def load_engine(multipv=1):
+    """
+    Worker initializer. Every worker gets its own engine (and therefore its own global state),
+    searching single-threaded so that the pool – not OpenMP – spreads work across cores
+    """
+    global ChessEngine
+    os.environ["OMP_NUM_THREADS"] = "1"
+    ChessEngine = ctypes.CDLL(so_file)
+    ChessEngine.lichess.restype = ctypes.c_char_p
+    if multipv > 1 and hasattr(ChessEngine, "multipv_set"):
+        ChessEngine.multipv_set(multipv)
+
+
+def to_fen(line):
+    """
+    EPD records have no move clocks, and may carry opcodes after the fourth field. Returns None for
+    blank and comment lines
+    """
+    fields = line.split()
+    if len(fields) < 4 or line.startswith("#"):
+        return None
+    if len(fields) >= 6 and fields[4].isdigit() and fields[5].isdigit():
+        return " ".join(fields[:6])
+    return " ".join(fields[:4]) + " 0 1"
+
+
+def multipv_lines():
+    """
+    @return info line of each PV from the last search, best first. Empty if the engine has no multi-PV support
+    """
+    if not hasattr(ChessEngine, "multipv_last_info"):
+        return []
+    lines = []
+    buf = ctypes.create_string_buffer(4096)
+    while ChessEngine.multipv_last_info(len(lines), buf, len(buf)) > 0:
+        lines.append(buf.value.decode())
+    return lines
+
+
+def uci_score(score):
+    """
+    @return score as UCI writes it: "cp <centipawns>", or "mate <moves>" (negative when getting mated)
+    """
+    if abs(score) >= MATE_SCORE - MAX_PLY:
+        moves = (MATE_SCORE - abs(score) + 1) // 2
+        return f"mate {moves if score > 0 else -moves}"
+    return f"cp {score}"
+
+
+def analyse(fen):
+    """
+    @return fen, best move, score, depth, nodes, milliseconds and the multi-PV info lines
+    """
+    res = ChessEngine.lichess(bytes(fen, 'utf-8'), b"").decode()
+    result = SearchResult()
+    ChessEngine.search_last_result(ctypes.byref(result))
+    return fen, res, uci_score(result.score), result.depth, result.nodes, result.time, multipv_lines()
+
+
+def fens_in(lines, window):
+    """
+    Yields the positions in lines, blocking once window.acquire() does, ie. while the pool holds too many
+    """
+    for line in lines:
+        fen = to_fen(line.strip())
+        if fen is not None:
+            window.acquire()
+            yield fen
+
+
+def run_batch(lines, out, workers, chunk_size, multipv=1):
+    """
+    Streams every position through one Pool.imap. imap reads its input on a thread of its own as fast as it can,
+    so a semaphore released per written result keeps at most chunk_size positions read but not yet written
+    """
+    positions = 0
+    chunk_size = max(chunk_size, 2 * workers)
+    window = threading.Semaphore(chunk_size)
+    tasks_per_send = max(1, chunk_size // (4 * workers))  # Several batches per worker in flight, so none idles
+    with multiprocessing.Pool(workers, initializer=load_engine, initargs=(multipv,)) as pool:
+        results = pool.imap(analyse, fens_in(lines, window), chunksize=tasks_per_send)
+        for fen, best_move, score, depth, nodes, elapsed_ms, pvs in results:
+            fields = [fen, best_move, score, str(depth), str(nodes), str(elapsed_ms)]
+            out.write("\t".join(fields + (pvs if multipv > 1 else [])) + "\n")
+            window.release()
+            positions += 1
+            if positions % tasks_per_send == 0:
+                out.flush()
+        out.flush()
+    return positions
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Find the best move for many FEN / EPD positions in parallel")
+    parser.add_argument("input", nargs="?", default="-", help="file with one FEN or EPD per line (default: stdin)")
+    parser.add_argument("--workers", type=int, default=os.cpu_count(), help="worker processes (default: all cores)")
+    parser.add_argument("--chunk", type=int, default=4096, help="most positions read ahead of the output")
+    parser.add_argument("--multipv", type=int, default=1, help="also report the top N moves with scores and PVs")
+    parser.add_argument("--output", default="-", help="result file (default: stdout)")
+    args = parser.parse_args()
+
+    lines = sys.stdin if args.input == "-" else open(args.input)
+    out = sys.stdout if args.output == "-" else open(args.output, "w")
+    start = time.perf_counter()
+    positions = run_batch(lines, out, max(1, args.workers), max(1, args.chunk), max(1, args.multipv))
+    elapsed = time.perf_counter() - start
+    print(f"Analysed {positions} positions in {elapsed:.1f}s ({positions / max(elapsed, 1e-9):.1f} positions/s)",
+          file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
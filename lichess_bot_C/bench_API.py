@@ -0,0 +1,78 @@
+"""
+Reproducible performance number for a build of the C engine.
+
+Searches the engine's bench positions (src/bench.c) single-threaded and prints elapsed time, positions and nodes
+per second, the transposition table's probe latency, and a signature: the total node count. The signature only
+changes when the search changes, so it tells functional changes apart from pure speed changes. It matches the
+command line engine's "bench" (1784012 nodes at the time of writing).
+
+With --threads N the engine searches with N OpenMP threads instead, and --pin pins them to CPUs spread over
+NUMA nodes: compare the two at high thread counts on multi-socket machines.
+
+Usage: python3 bench_API.py [--hash MB] [--no-huge-pages] [--threads N] [--pin]
+"""
+import argparse
+import os
+import sys
+import time
+
+os.environ["OMP_NUM_THREADS"] = "1"  # Must be set before the engine (and libomp) is loaded. See --threads
+
+import ctypes
+
+so_file = sys.path[0] + "/lichess_bot/engines/ChessEngine.so"
+
+BENCH_POSITIONS = 50  # As in src/bench.h
+PAGE_KINDS = ["normal", "transparent huge", "explicit huge"]  # enum pageKind in src/lib/large_alloc.h
+LATENCY_PROBES = 1000000
+
+
+class SearchResult(ctypes.Structure):
+    """struct search_result in src/search.h"""
+    _fields_ = [("move", ctypes.c_char * 8), ("score", ctypes.c_int), ("depth", ctypes.c_int),
+                ("nodes", ctypes.c_uint64), ("time", ctypes.c_int64)]
+
+
+def bench(hash_mb, huge_pages, pin, threads):
+    ChessEngine = ctypes.CDLL(so_file)
+    ChessEngine.lichess.restype = ctypes.c_char_p
+    ChessEngine.tt_probe_latency.restype = ctypes.c_double
+    if pin and hasattr(ChessEngine, "affinity_pin_omp_threads"):
+        ChessEngine.affinity_set_enabled(True)
+        ChessEngine.affinity_pin_omp_threads()  # Before tt_resize, so the table is interleaved over nodes
+        print(f"Threads pinned over {ChessEngine.affinity_num_nodes()} NUMA node(s)")
+    if hasattr(ChessEngine, "tt_resize"):
+        ChessEngine.tt_set_huge_pages(huge_pages)
+        ChessEngine.tt_resize(ctypes.c_size_t(hash_mb))
+        print(f"Hash: {hash_mb} MB, {PAGE_KINDS[ChessEngine.tt_page_kind()]} pages")
+    if hasattr(ChessEngine, "search_set_threads"):
+        ChessEngine.search_set_threads(threads)
+
+    bench_fens = (ctypes.c_char_p * BENCH_POSITIONS).in_dll(ChessEngine, "bench_fens")
+    nodes = 0
+    result = SearchResult()
+    start = time.perf_counter()
+    for fen in bench_fens:
+        ChessEngine.lichess(fen, b"")
+        ChessEngine.search_last_result(ctypes.byref(result))
+        nodes += result.nodes
+    elapsed = time.perf_counter() - start
+    latency = ChessEngine.tt_probe_latency(LATENCY_PROBES)  # After the searches, so the table is warm and full
+
+    print(f"Positions: {BENCH_POSITIONS}")
+    print(f"Time (ms): {elapsed * 1000:.0f}")
+    print(f"Positions/second: {BENCH_POSITIONS / elapsed:.2f}")
+    print(f"Nodes/second: {nodes / elapsed:.0f}")
+    print(f"TT probe latency (ns): {latency:.1f}")
+    print(f"Signature (nodes): {nodes}")
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description="Time the engine on a fixed set of positions")
+    parser.add_argument("--hash", type=int, default=16, help="transposition table size in MB")
+    parser.add_argument("--no-huge-pages", action="store_true", help="back the table with normal pages")
+    parser.add_argument("--threads", type=int, default=1, help="search threads (above 1 the signature varies run to run)")
+    parser.add_argument("--pin", action="store_true", help="pin search threads to CPUs, spread over NUMA nodes")
+    args = parser.parse_args()
+    os.environ["OMP_NUM_THREADS"] = str(max(1, args.threads))
+    bench(max(1, args.hash), not args.no_huge_pages, args.pin, max(1, args.threads))
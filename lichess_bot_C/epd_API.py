@@ -0,0 +1,147 @@
+"""
+Runs an EPD test suite (WAC, ECM, STS, ...) through the C engine and reports how many positions it solves.
+
+A position is solved when the engine's move is one of the `bm` (best move) operands, or – for
+avoid-move records – none of the `am` operands. Operands are SAN, resolved against the legal moves by
+python-chess (as installed for the lichess bot, see lichess_bot/requirements.txt).
+Each position gets the same budget: --nodes, --movetime and / or --depth.
+Its time-to-solution is when the engine settled on a solving move: the first iteration from which every later
+one, and the final answer, solve it. Positions run in parallel, one engine per worker.
+
+Usage: python3 epd_API.py suite.epd [--nodes N] [--movetime MS] [--depth N] [--workers N] [--quiet]
+"""
+import argparse
+import ctypes
+import multiprocessing
+import os
+import time
+
+import chess
+
+import batch_API
+
+MAX_PLY = 128  # As in src/search.h: no search has more iterations
+
+
+def load_engine(nodes, movetime, depth):
+    """
+    Worker initializer: batch_API's engine, with this suite's search budget
+    """
+    batch_API.load_engine()
+    batch_API.ChessEngine.search_set_nodes(ctypes.c_uint64(nodes))
+    batch_API.ChessEngine.search_set_movetime(ctypes.c_int64(movetime))
+    batch_API.ChessEngine.search_set_depth(depth)
+
+
+def parse_epd(line):
+    """
+    @return (fen, ops) where ops maps each opcode to its list of operands, or None for blank / comment lines
+    """
+    fields = line.split(maxsplit=4)
+    if len(fields) < 4 or line.startswith("#"):
+        return None
+    fen = " ".join(fields[:4]) + " 0 1"
+
+    ops = {}
+    for op in (fields[4] if len(fields) > 4 else "").split(";"):
+        op = op.strip()
+        if not op:
+            continue
+        opcode, _, operands = op.partition(" ")
+        operands = operands.strip()
+        if operands.startswith('"'):
+            ops[opcode] = [operands.strip('"')]
+        else:
+            ops[opcode] = operands.split()
+    return fen, ops
+
+
+def san_moves(fen, operands):
+    """
+    @return UCI of each SAN operand that is a legal move in fen. Annotations ("!", "?") and en passant suffixes
+    ("exd6 e.p." or "exd6ep") are dropped first; operands that are not legal moves are skipped
+    """
+    board = chess.Board(fen)
+    moves = set()
+    for san in operands:
+        san = san.rstrip("!?")
+        if san.endswith("e.p."):
+            san = san[:-len("e.p.")]
+        elif san.endswith("ep"):
+            san = san[:-len("ep")]
+        if not san:
+            continue
+        try:
+            moves.add(board.parse_san(san).uci())
+        except ValueError:
+            pass
+    return moves
+
+
+def time_to_solution(iterations, solves, final):
+    """
+    @param iterations SearchResult of each completed iteration, shallowest first
+    @param solves Whether a UCI move solves the position
+    @param final SearchResult of the whole search, which solved it
+    @return Time (ms) of the first iteration from which the best move always solved it
+    """
+    settled = final.time
+    for iteration in reversed(iterations):
+        if not solves(iteration.move.decode()):
+            break
+        settled = iteration.time
+    return settled
+
+
+def run_position(record):
+    fen, ops = record
+    ChessEngine = batch_API.ChessEngine
+    best_move = ChessEngine.lichess(bytes(fen, 'utf-8'), b"").decode()
+    final = batch_API.SearchResult()
+    ChessEngine.search_last_result(ctypes.byref(final))
+    iterations = (batch_API.SearchResult * MAX_PLY)()
+    iterations = iterations[:ChessEngine.search_iterations(iterations, MAX_PLY)]
+
+    if "bm" in ops:
+        best = san_moves(fen, ops["bm"])
+        solves = lambda move: move in best
+    else:
+        avoid = san_moves(fen, ops.get("am", []))
+        solves = lambda move: move not in avoid
+    solved = solves(best_move)
+    elapsed_ms = time_to_solution(iterations, solves, final) if solved else final.time
+    return ops.get("id", [fen])[0], best_move, solved, elapsed_ms
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Measure solve rate and time-to-solution on an EPD suite")
+    parser.add_argument("suite", help="EPD file with bm / am / id opcodes")
+    parser.add_argument("--nodes", type=int, default=0, help="node budget per position (0: none)")
+    parser.add_argument("--movetime", type=int, default=0, help="time budget per position in ms (0: none)")
+    parser.add_argument("--depth", type=int, default=0, help="depth budget per position (0: engine default)")
+    parser.add_argument("--workers", type=int, default=os.cpu_count(), help="worker processes (default: all cores)")
+    parser.add_argument("--quiet", action="store_true", help="only print the summary")
+    args = parser.parse_args()
+
+    with open(args.suite) as f:
+        records = [r for r in map(parse_epd, f) if r is not None and ("bm" in r[1] or "am" in r[1])]
+
+    start = time.perf_counter()
+    solved_times = []
+    budget = (max(0, args.nodes), max(0, args.movetime), max(0, args.depth))
+    with multiprocessing.Pool(max(1, args.workers), initializer=load_engine, initargs=budget) as pool:
+        for position_id, best_move, solved, elapsed_ms in pool.imap(run_position, records):
+            if solved:
+                solved_times.append(elapsed_ms)
+            if not args.quiet:
+                print(f"{'ok  ' if solved else 'FAIL'} {position_id}: {best_move} ({elapsed_ms:.0f} ms)")
+    elapsed = time.perf_counter() - start
+
+    average = sum(solved_times) / len(solved_times) if solved_times else 0
+    print(f"Solved {len(solved_times)} / {len(records)}")
+    print(f"Average time-to-solution: {average:.0f} ms")
+    print(f"Total time: {elapsed:.1f}s")
+
+
+if __name__ == '__main__':
+    main()
@@ -15,6 +15,7 @@ import time
 import backoff
 import sys
 import random
+import ctypes
 from config import load_config
 from conversation import Conversation, ChatLine
 from functools import partial
@@ -22,6 +23,7 @@ from requests.exceptions import ChunkedEncodingError, ConnectionError, HTTPError
 from urllib3.exceptions import ProtocolError
 from ColorLogger import enable_color_logging
 from collections import defaultdict
+from strategies import load_c_engine
 
 logger = logging.getLogger(__name__)
 
@@ -361,6 +363,11 @@ def get_book_move(board, polyglot_cfg):
     if isinstance(books, str):
         books = [books]
 
+    if board.uci_variant == "chess":
+        probed, move = get_c_book_move(board, books, polyglot_cfg)
+        if probed:  # The engine read every book already, so python-chess would find nothing more
+            return chess.engine.PlayResult(move, None) if move is not None else no_book_move
+
     for book in books:
         with chess.polyglot.open_reader(book) as reader:
             try:
@@ -382,6 +389,36 @@ def get_book_move(board, polyglot_cfg):
     return no_book_move
 
 
+c_books = {}  # Book path -> handle of the book memory-mapped by the C engine
+
+
+def get_c_book_move(board, books, polyglot_cfg):
+    """
+    Probes the books through the C engine, which maps each file once instead of reopening it every move.
+    Returns (probed, move): probed is False if the engine library does not provide books, and move is None
+    if no book has a move
+    """
+    try:
+        ChessEngine = load_c_engine()
+        ChessEngine.book_open.restype = ctypes.c_void_p
+        ChessEngine.book_move_fen.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_int, ctypes.c_int,
+                                              ctypes.c_uint64, ctypes.c_char_p]
+    except (OSError, AttributeError):
+        return False, None
+
+    selection = {"best_move": 0, "weighted_random": 1, "uniform_random": 2}[polyglot_cfg.get("selection", "weighted_random")]
+    res = ctypes.create_string_buffer(6)
+    for book in books:
+        if book not in c_books:
+            c_books[book] = ChessEngine.book_open(bytes(book, 'utf-8'))
+        if c_books[book] and ChessEngine.book_move_fen(c_books[book], bytes(board.fen(), 'ascii'), selection,
+                                                       polyglot_cfg.get("min_weight", 1), random.getrandbits(64), res):
+            move = chess.Move.from_uci(res.value.decode())
+            logger.info("Got move {} from book {}".format(move, book))
+            return True, move
+    return True, None
+
+
 def get_chessdb_move(li, board, game, chessdb_cfg):
     wb = 'w' if board.turn == chess.WHITE else 'b'
     if not chessdb_cfg.get("enabled", False) or game.state[f"{wb}time"] < chessdb_cfg.get("min_time", 20) * 1000 or board.uci_variant != "chess":
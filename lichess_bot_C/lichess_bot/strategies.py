@@ -4,11 +4,21 @@ And some handy classes to extend
 """
 
 import chess
+import chess.polyglot
 from chess.engine import PlayResult
 import random
 from engine_wrapper import EngineWrapper
 import ctypes
 import sys
+import os
+import functools
+import threading
+
+PONDER_STOP_RETRY = 0.01  # Seconds between tm_stop calls while waiting for the ponder thread
+
+# Library (ChessEngine-<name>.so from `make variants`) that plays each variant by its rules, by c_variant
+VARIANT_LIBRARIES = {"chess960": "chess960", "fromPosition": "chess960", "3check": "threecheck",
+                     "kingofthehill": "koth", "crazyhouse": "crazyhouse"}
 
 class FillerEngine:
     """
@@ -91,20 +101,203 @@ class MinimalEngine(EngineWrapper):
 class ExampleEngine(MinimalEngine):
     pass
 
+def c_variant(board):
+    """
+    Variant of board's game, as a key of VARIANT_LIBRARIES: its uci_variant, except that standard boards are
+    "chess960" or "fromPosition" (any other starting position, which may castle with rooks off the corners)
+    """
+    if board.uci_variant != "chess":
+        return board.uci_variant
+    if board.chess960:
+        return "chess960"
+    return "fromPosition" if board.root().fen() != chess.STARTING_FEN else "chess"
+
+
+@functools.lru_cache(maxsize=None)
+def load_c_engine(variant="chess"):
+    """
+    Loads the library for variant (see VARIANT_LIBRARIES) if `make variants` built it. Otherwise, and for standard
+    chess, loads the fastest ChessEngine-<flavour>.so this CPU supports (see `make flavours`), falling back to the
+    plain ChessEngine.so from `make lichess`. The standard build plays other variants by the standard rules.
+    """
+    engine_dir = sys.path[0] + "/engines/"
+    so_file = engine_dir + "ChessEngine.so"
+    variant_file = engine_dir + f"ChessEngine-{VARIANT_LIBRARIES.get(variant)}.so"
+    if variant in VARIANT_LIBRARIES and os.path.exists(variant_file):
+        so_file = variant_file
+    elif os.path.exists(engine_dir + "cpu_features.so"):  # cpuid alone, without loading a whole engine
+        cpu = ctypes.CDLL(engine_dir + "cpu_features.so")
+        cpu.cpu_flavour_name.restype = ctypes.c_char_p
+        for flavour in range(cpu.cpu_best_flavour(), -1, -1):
+            name = cpu.cpu_flavour_name(flavour).decode()
+            if os.path.exists(engine_dir + f"ChessEngine-{name}.so"):
+                so_file = engine_dir + f"ChessEngine-{name}.so"
+                break
+    ChessEngine = ctypes.CDLL(so_file)
+    ChessEngine.lichess.restype = ctypes.c_char_p
+    if hasattr(ChessEngine, "bitbase_init"):
+        ChessEngine.bitbase_init(bytes(engine_dir, 'utf-8'))  # Maps the files from `make bitbases`, if any
+    return ChessEngine
+
+
+def set_c_game_history(ChessEngine, board):
+    """
+    Hands the engine the Zobrist keys of the positions before board, back to the last capture or pawn move,
+    so its search can see repetitions of them. Polyglot keys, which are what the engine computes
+    """
+    if not hasattr(ChessEngine, "history_set_game"):
+        return
+    earlier = board.copy()
+    keys = []
+    for _ in range(min(board.halfmove_clock, len(board.move_stack))):
+        earlier.pop()
+        keys.append(chess.polyglot.zobrist_hash(earlier))
+    keys.reverse()
+    ChessEngine.history_set_game((ctypes.c_uint64 * len(keys))(*keys), len(keys))
+
+
 class C_Engine(ExampleEngine):
     """C engine: uses minimax with depth 4"""
 
+    def __init__(self, *args, **kwargs):
+        super().__init__(*args, **kwargs)
+        self.options = (args[1] if len(args) > 1 else None) or {}  # homemade_options in config.yml
+        self.ChessEngine = None  # Library of the game's variant, picked by c_engine at the first search
+        self.ponder_lock = threading.Lock()  # Orders tm_ponder against tm_stop / tm_ponderhit
+        self.ponder_thread = None
+        self.ponder_board = None    # Position after our move and the reply we expect
+        self.ponder_started = False
+        self.ponder_cancelled = False
+        self.ponder_result = None
+
+    def c_engine(self, board):
+        """
+        Library for board's variant (see load_c_engine), with the options applied the first time this engine uses it
+        """
+        ChessEngine = load_c_engine(c_variant(board))
+        if ChessEngine is self.ChessEngine:
+            return ChessEngine
+        self.ChessEngine = ChessEngine
+        options = self.options
+        if options.get("Pin Threads") and hasattr(ChessEngine, "affinity_pin_omp_threads"):
+            ChessEngine.affinity_set_enabled(True)
+            ChessEngine.affinity_pin_omp_threads()  # Before tt_resize, so the table is interleaved over NUMA nodes
+        if "Hash" in options and hasattr(ChessEngine, "tt_resize"):
+            ChessEngine.tt_resize(ctypes.c_size_t(int(options["Hash"])))
+        if "Threads" in options and hasattr(ChessEngine, "search_set_threads"):
+            ChessEngine.search_set_threads(int(options["Threads"]))
+        if "SyzygyPath" in options and hasattr(ChessEngine, "tb_init"):
+            ChessEngine.tb_init(bytes(options["SyzygyPath"], 'utf-8'))
+        return ChessEngine
+
+    def search_with_ponder(self, board, wtime, btime, winc, binc, ponder, draw_offered):
+        ChessEngine = self.c_engine(board)
+        timeleft, inc = (wtime, winc) if board.turn else (btime, binc)
+        result = self.finish_ponder(board, timeleft, inc)
+        if result is None:
+            if hasattr(ChessEngine, "tm_set_clock"):  # Let the engine's time manager budget this move
+                ChessEngine.tm_set_clock(ctypes.c_int64(timeleft), ctypes.c_int64(inc), 0)
+            result = super().search_with_ponder(board, wtime, btime, winc, binc, ponder, draw_offered)
+        if ponder and hasattr(ChessEngine, "tm_ponder"):
+            opponent_time, opponent_inc = (btime, binc) if board.turn else (wtime, winc)
+            self.start_ponder(board, result.move, opponent_time, opponent_inc)
+        return result
+
+    def first_search(self, board, movetime, draw_offered):
+        ChessEngine = self.c_engine(board)
+        if hasattr(ChessEngine, "tt_clear"):  # New game (ucinewgame)
+            self.stop()
+            ChessEngine.tt_clear()
+        return super().first_search(board, movetime, draw_offered)
+
     def search(self, board, *args):
-        so_file = sys.path[0] + "/engines/ChessEngine.so"
-        ChessEngine = ctypes.CDLL(so_file)
-        ChessEngine.lichess.restype = ctypes.c_char_p
+        ChessEngine = self.c_engine(board)
         print(f"Input string is: {board.fen()}")
 
+        set_c_game_history(ChessEngine, board)
         UCI_move = ChessEngine.lichess(bytes(board.fen(), 'ascii'), "")
-        UCI_move = UCI_move.decode()
+        UCI_move = board.parse_uci(UCI_move.decode()).uci()  # The Chess960 build castles as king takes rook
         print(f"Move: {UCI_move}")
         return PlayResult(UCI_move, None)
 
+    def start_ponder(self, board, move, opponent_time, opponent_inc):
+        """
+        Thinks on the opponent's time: a short search predicts their reply, then the position after it is searched
+        with no time limit until finish_ponder either converts it into our real search or throws it away.
+        Either way the transposition table keeps what was learnt
+        """
+        after_move = board.copy()
+        after_move.push(chess.Move.from_uci(str(move)))
+        if after_move.is_game_over():
+            return
+        self.ponder_board = None
+        self.ponder_started = False
+        self.ponder_cancelled = False
+        self.ponder_result = None
+
+        ChessEngine = self.c_engine(board)
+
+        def ponder():
+            ChessEngine.tm_set_clock(ctypes.c_int64(opponent_time // 10), ctypes.c_int64(opponent_inc // 10), 0)
+            set_c_game_history(ChessEngine, after_move)
+            reply = after_move.parse_uci(ChessEngine.lichess(bytes(after_move.fen(), 'ascii'), "").decode())
+            expected = after_move.copy()
+            expected.push(reply)
+            if expected.is_game_over():
+                return
+            with self.ponder_lock:
+                if self.ponder_cancelled:
+                    return
+                ChessEngine.tm_ponder(True)
+                self.ponder_board = expected
+                self.ponder_started = True
+            set_c_game_history(ChessEngine, expected)
+            self.ponder_result = ChessEngine.lichess(bytes(expected.fen(), 'ascii'), "").decode()
+
+        self.ponder_thread = threading.Thread(target=ponder, daemon=True)
+        self.ponder_thread.start()
+
+    def finish_ponder(self, board, timeleft, inc):
+        """
+        The opponent has moved. On a ponder hit the running search gets our clock and becomes the real search;
+        on a miss it is stopped and its move discarded
+        @return PlayResult of the ponder search on a hit, otherwise None
+        """
+        if self.ponder_thread is None:
+            return None
+        ChessEngine = self.c_engine(board)
+        with self.ponder_lock:
+            hit = self.ponder_started and self.ponder_board is not None and self.ponder_board.fen() == board.fen()
+            if hit:
+                ChessEngine.tm_set_clock(ctypes.c_int64(timeleft), ctypes.c_int64(inc), 0)
+                ChessEngine.tm_ponderhit()
+            else:
+                self.ponder_cancelled = True
+        if hit:
+            self.ponder_thread.join()
+            self.ponder_thread = None
+        else:
+            self.stop()
+        if hit and self.ponder_result:
+            move = board.parse_uci(self.ponder_result).uci()
+            print(f"Ponder hit. Move: {move}")
+            return PlayResult(move, None)
+        return None
+
+    def stop(self):
+        """
+        Cancels pondering and waits for the ponder thread. tm_stop is repeated until the thread ends: the
+        prediction search clears a stop that arrives before it starts
+        """
+        if self.ponder_thread is None:
+            return
+        with self.ponder_lock:
+            self.ponder_cancelled = True
+        while self.ponder_thread.is_alive():
+            self.ChessEngine.tm_stop()
+            self.ponder_thread.join(PONDER_STOP_RETRY)
+        self.ponder_thread = None
+
 # Strategy names and ideas from tom7's excellent eloWorld video
 class RandomMove(ExampleEngine):
     def search(self, board, *args):
@@ -0,0 +1,119 @@
+//
+// Pinning search threads to CPUs, spread over NUMA nodes. Linux only; elsewhere every call is a no-op.
+//
+
+#define _GNU_SOURCE  // pthread_setaffinity_np, CPU_SET
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <omp.h>
+
+#include "lib/contracts.h"
+#include "affinity.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#define MPOL_INTERLEAVE 3  // From linux/mempolicy.h, which libc does not ship
+#endif
+
+static bool enabled = false;
+
+#ifdef __linux__
+static bool topology_read = false;
+static int num_nodes = 1;
+static int node_cpus[MAX_NUMA_NODES][CPU_SETSIZE];  // Allowed CPUs of each node
+static int node_num_cpus[MAX_NUMA_NODES];
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Groups the CPUs this process may use by NUMA node, from /sys/devices/system/cpu/cpu<N>/node<M>
+ */
+static void _read_topology(void) {
+    if (topology_read) return;
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return;
+
+    int highest = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+        int node = 0;
+        for (int n = 0; n < MAX_NUMA_NODES; n++) {
+            char path[64];
+            snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/node%d", cpu, n);
+            if (access(path, F_OK) == 0) {
+                node = n;
+                break;
+            }
+        }
+        node_cpus[node][node_num_cpus[node]++] = cpu;
+        if (node > highest) highest = node;
+    }
+    num_nodes = highest + 1;
+    topology_read = true;
+}
+#endif
+
+
+void affinity_set_enabled(bool on) {
+    enabled = on;
+}
+
+
+int affinity_num_nodes(void) {
+#ifdef __linux__
+    _read_topology();
+    return num_nodes;
+#else
+    return 1;
+#endif
+}
+
+
+int affinity_pin_thread(int thread) {
+    REQUIRES(thread >= 0);
+    if (!enabled) return -1;
+#ifdef __linux__
+    _read_topology();
+    // Skip nodes without allowed CPUs (ie. memory-only nodes)
+    int node = thread % num_nodes;
+    for (int tries = 0; node_num_cpus[node] == 0 && tries < num_nodes; tries++) node = (node + 1) % num_nodes;
+    if (node_num_cpus[node] == 0) return -1;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(node_cpus[node][(thread / num_nodes) % node_num_cpus[node]], &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) return -1;
+    return node;
+#else
+    return -1;
+#endif
+}
+
+
+void affinity_pin_omp_threads(void) {
+    if (!enabled) return;
+    #pragma omp parallel
+    affinity_pin_thread(omp_get_thread_num());
+}
+
+
+void affinity_interleave(void *p, size_t size) {
+    REQUIRES(p != NULL);
+#if defined(__linux__) && defined(SYS_mbind)
+    if (!enabled || affinity_num_nodes() < 2) return;
+    unsigned long mask = 0;
+    for (int node = 0; node < num_nodes && node < (int) (8 * sizeof(mask)); node++) {
+        if (node_num_cpus[node] > 0) mask |= 1UL << node;
+    }
+    syscall(SYS_mbind, p, size, MPOL_INTERLEAVE, &mask, 8 * sizeof(mask), 0);  // Best effort: ignore failure
+#else
+    (void) size;
+#endif
+}
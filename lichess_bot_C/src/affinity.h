@@ -0,0 +1,47 @@
+//
+// Pinning search threads to CPUs, spread over NUMA nodes. Linux only; elsewhere every call is a no-op.
+//
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef CHESS_AFFINITY_H
+#define CHESS_AFFINITY_H
+
+#define MAX_NUMA_NODES 64
+
+/**
+ * Turns pinning on or off (default off). Exported for the Python (ctypes) side
+ * @param on
+ */
+void affinity_set_enabled(bool on);
+
+/**
+ * @return Number of NUMA nodes among the CPUs this process may run on (1 if unknown)
+ */
+int affinity_num_nodes(void);
+
+/**
+ * Pins the calling thread, if enabled. Thread i goes to node i % nodes, on the next free CPU of that node, so
+ * threads are spread evenly over sockets. Memory the thread touches first afterwards (its stack, history
+ * tables, pawn hash) is then placed on its own node by the kernel
+ * @param thread Index of the search thread, ie. omp_get_thread_num()
+ * @return Node the thread was pinned to, or -1 if it was not pinned
+ */
+int affinity_pin_thread(int thread);
+
+/**
+ * Pins every thread of the OpenMP pool (if enabled). OpenMP reuses its threads between parallel regions,
+ * so once is enough per team size. Exported for the Python (ctypes) side
+ */
+void affinity_pin_omp_threads(void);
+
+/**
+ * Interleaves the pages of shared memory (ie. the transposition table) across NUMA nodes, if enabled and there
+ * is more than one, so no single node's memory controller serves every probe. Call before the memory is touched
+ * @param p Page-aligned
+ * @param size
+ */
+void affinity_interleave(void *p, size_t size);
+
+#endif //CHESS_AFFINITY_H
@@ -0,0 +1,18 @@
+//
+// Bench: a fixed set of positions searched to a fixed depth, as a reproducible speed and behaviour check.
+//
+
+#ifndef CHESS_BENCH_H
+#define CHESS_BENCH_H
+
+#define BENCH_POSITIONS 50
+#define BENCH_DEPTH DEFAULT_SEARCH_DEPTH  // search.h. What lichess() searches with no limit set, as in bench_API.py
+
+/**
+ * FENs searched by the UCI "bench" command and by bench_API.py (through ctypes), openings first, then middle
+ * games and endgames. Searched one after the other from an empty transposition table, single-threaded, their
+ * total node count is the bench signature: it only changes when the search does
+ */
+extern const char *const bench_fens[BENCH_POSITIONS];
+
+#endif //CHESS_BENCH_H
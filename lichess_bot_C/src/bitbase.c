@@ -0,0 +1,248 @@
+//
+// Win / draw bitbases for king + pawn, rook or queen vs king, generated by retrograde analysis.
+//
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "lib/contracts.h"
+#include "lib/xalloc.h"
+#include "dataStructs.h"
+#include "board_manipulations.h"
+#include "variant.h"
+#include "movegen.h"
+#include "bitbase.h"
+
+enum bitbaseResult {invalid=0, unknown=1, draw=2, win=4};
+
+static const uint64_t *bitbases[whiteKing];  // Mapped files, indexed by the strong side's piece
+// KNvK and KBvK are always draws, which the material table already knows (egDraw)
+static const char *file_names[whiteKing] = {"KPvK.bb", NULL, NULL, "KRvK.bb", "KQvK.bb"};
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Squares the strong side's piece on sq attacks, from the move generator's tables
+ */
+static uint64_t _piece_attacks(enum EPieceType piece, enum enumSquare sq, uint64_t occ) {
+    switch (piece) {
+        case whitePawns:
+            return pawn_attacks(sq, true);
+        case whiteRooks:
+            return rook_attacks(sq, occ);
+        case whiteQueens:
+            return rook_attacks(sq, occ) | bishop_attacks(sq, occ);
+        default:
+            ASSERT(false);
+            return 0;
+    }
+}
+
+
+/**********************
+ * GENERATION
+**********************/
+static int _index(bool strongToMove, int sk, int wk, int ps) {
+    return ((!strongToMove * 64 + sk) * 64 + wk) * 64 + ps;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Classifies a position that needs no search: illegal, mate, stalemate or a capture of the piece
+ */
+static enum bitbaseResult _initial(enum EPieceType piece, bool strongToMove, int sk, int wk, int ps) {
+    if (sk == wk || sk == ps || wk == ps) return invalid;
+    if (king_attacks(sk) & (1UL << wk)) return invalid;
+    if (piece == whitePawns && (ps < a2 || ps > h7)) return invalid;
+
+    uint64_t occ = (1UL << sk) | (1UL << ps);  // Weak king does not block attacks on squares behind it
+    uint64_t checks = _piece_attacks(piece, ps, occ);
+    if (strongToMove) return (checks & (1UL << wk)) ? invalid : unknown;
+
+    // Weak side can take an undefended piece
+    if ((king_attacks(wk) & (1UL << ps)) && !(king_attacks(sk) & (1UL << ps))) return draw;
+
+    uint64_t escapes = king_attacks(wk) & ~king_attacks(sk) & ~checks & ~(1UL << ps);
+    if (!escapes) return (checks & (1UL << wk)) ? win : draw;  // Mate or stalemate
+    return unknown;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * One retrograde step for an unknown position, reading the previous iteration's results
+ */
+static enum bitbaseResult _step(enum EPieceType piece, const unsigned char *prev, bool strongToMove,
+                                int sk, int wk, int ps) {
+    uint64_t occ = (1UL << sk) | (1UL << wk) | (1UL << ps);
+
+    if (strongToMove) {  // Win if any move wins. Draw only once every move is a proven draw
+        enum bitbaseResult r = draw;
+        uint64_t kingMoves = king_attacks(sk) & ~king_attacks(wk) & ~(1UL << ps);
+        while (kingMoves) {
+            int to = bitScanForward(kingMoves);
+            kingMoves &= kingMoves - 1;
+            r |= prev[_index(false, to, wk, ps)];
+        }
+
+        uint64_t pieceMoves;
+        if (piece == whitePawns) {
+            int push = ps + 8;
+            pieceMoves = 0;
+            if (!(occ & (1UL << push))) {
+                if (push >= a8) {
+                    // Promotion wins unless the new queen is simply captured
+                    if (!(king_attacks(wk) & (1UL << push)) || (king_attacks(sk) & (1UL << push))) return win;
+                    r |= draw;
+                }
+                else {
+                    pieceMoves |= 1UL << push;
+                    if (ps < a3 && !(occ & (1UL << (push + 8)))) pieceMoves |= 1UL << (push + 8);
+                }
+            }
+        }
+        else pieceMoves = _piece_attacks(piece, ps, occ) & ~occ;
+        while (pieceMoves) {
+            int to = bitScanForward(pieceMoves);
+            pieceMoves &= pieceMoves - 1;
+            r |= prev[_index(false, sk, wk, to)];
+        }
+
+        if (r & win) return win;
+        if (r & unknown) return unknown;
+        return draw;
+    }
+
+    // Weak to move: draw if any move draws. Win only once every move is a proven win
+    enum bitbaseResult r = invalid;
+    uint64_t checks = _piece_attacks(piece, ps, (1UL << sk) | (1UL << ps));
+    uint64_t kingMoves = king_attacks(wk) & ~king_attacks(sk) & ~checks & ~(1UL << ps);
+    while (kingMoves) {
+        int to = bitScanForward(kingMoves);
+        kingMoves &= kingMoves - 1;
+        r |= prev[_index(true, sk, to, ps)];
+    }
+    if (r & draw) return draw;
+    if (r & unknown) return unknown;
+    return win;
+}
+
+
+void bitbase_generate(enum EPieceType piece, uint64_t *res) {
+    REQUIRES(whitePawns <= piece && piece < whiteKing && file_names[piece] != NULL && res != NULL);
+    movegen_init();
+    unsigned char *prev = xmalloc(BITBASE_POSITIONS);
+    unsigned char *next = xmalloc(BITBASE_POSITIONS);
+
+    #pragma omp parallel for
+    for (int i = 0; i < BITBASE_POSITIONS; i++) {
+        prev[i] = _initial(piece, i < BITBASE_POSITIONS / 2, (i >> 12) & 63, (i >> 6) & 63, i & 63);
+    }
+
+    // Double-buffered, so threads never read a result being written in the same pass
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        #pragma omp parallel for reduction(||:changed)
+        for (int i = 0; i < BITBASE_POSITIONS; i++) {
+            next[i] = prev[i];
+            if (prev[i] != unknown) continue;
+            next[i] = _step(piece, prev, i < BITBASE_POSITIONS / 2, (i >> 12) & 63, (i >> 6) & 63, i & 63);
+            changed = changed || next[i] != unknown;
+        }
+        unsigned char *tmp = prev;
+        prev = next;
+        next = tmp;
+    }
+
+    // Positions nobody can force anything from are draws, so only wins need a bit
+    memset(res, 0, BITBASE_BYTES);
+    for (int i = 0; i < BITBASE_POSITIONS; i++) {
+        if (prev[i] == win) res[i / 64] |= 1UL << (i % 64);
+    }
+    free(prev);
+    free(next);
+}
+
+
+/**********************
+ * FILES AND PROBING
+**********************/
+const char *bitbase_file_name(enum EPieceType piece) {
+    REQUIRES(whitePawns <= piece && piece < whiteKing);
+    return file_names[piece];
+}
+
+
+int bitbase_init(const char *dir) {
+    REQUIRES(dir != NULL);
+    bitbase_free();
+    int mapped = 0;
+    for (enum EPieceType piece = whitePawns; piece < whiteKing; piece++) {
+        if (file_names[piece] == NULL) continue;
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s", dir, file_names[piece]);
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) continue;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size == BITBASE_BYTES) {
+            void *map = mmap(NULL, BITBASE_BYTES, PROT_READ, MAP_SHARED, fd, 0);
+            if (map != MAP_FAILED) {
+                bitbases[piece] = map;
+                mapped++;
+            }
+        }
+        close(fd);
+    }
+    return mapped;
+}
+
+
+void bitbase_free(void) {
+    for (enum EPieceType piece = whitePawns; piece < whiteKing; piece++) {
+        if (bitbases[piece] != NULL) munmap((void *) bitbases[piece], BITBASE_BYTES);
+        bitbases[piece] = NULL;
+    }
+}
+
+
+bool bitbase_probe(FEN position, int *res) {
+    REQUIRES(position != NULL && res != NULL);
+#if VARIANT != VARIANT_STANDARD && VARIANT != VARIANT_CHESS960
+    return false;  // Other variants' rules change the results
+#else
+    uint64_t *BBoard = position->BBoard;
+    if (popCount(BBoard[whiteAll] | BBoard[blackAll]) != 3 || position->castling || position->crazyhouse) return false;
+
+    // The strong side is whoever has the piece. Black is mirrored onto white
+    bool whiteStrong = popCount(BBoard[whiteAll]) == 2;
+    int offset = whiteStrong ? 0 : colorOffset;
+    uint64_t pieceBB = BBoard[whiteAll + offset] & ~BBoard[whiteKing + offset];
+    enum EPieceType piece = whitePawns;
+    while (piece < whiteKing && !(BBoard[piece + offset] & pieceBB)) piece++;
+    if (piece == whiteKing || bitbases[piece] == NULL) return false;
+
+    int sk = bitScanForward(BBoard[whiteKing + offset]);
+    int wk = bitScanForward(BBoard[blackKing - offset]);
+    int ps = bitScanForward(pieceBB);
+    if (!whiteStrong) {
+        sk = FLIP(sk);
+        wk = FLIP(wk);
+        ps = FLIP(ps);
+    }
+
+    bool strongToMove = position->whiteToMove == whiteStrong;
+    int i = _index(strongToMove, sk, wk, ps);
+    bool strongWins = bitbases[piece][i / 64] & (1UL << (i % 64));
+    *res = strongWins ? (strongToMove ? 1 : -1) : 0;
+    return true;
+#endif
+}
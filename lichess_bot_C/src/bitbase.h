@@ -0,0 +1,52 @@
+//
+// Win / draw bitbases for king + pawn, rook or queen vs king, generated by retrograde analysis.
+//
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef CHESS_BITBASE_H
+#define CHESS_BITBASE_H
+
+/**
+ * One bit per position: strong side (the one with the extra piece) to move or not, strong king, weak king,
+ * piece square. Set bits are wins for the strong side, clear bits are draws or illegal positions
+ */
+#define BITBASE_POSITIONS (2 * 64 * 64 * 64)
+#define BITBASE_BYTES (BITBASE_POSITIONS / 8)
+
+/**
+ * Retrograde analysis of king + `piece` vs king, with the strong side as white.
+ * Iterates until no position changes, in parallel (OpenMP) over positions
+ * @param piece whitePawns, whiteRooks or whiteQueens
+ * @param res Buffer of BITBASE_BYTES, filled with the packed result
+ */
+void bitbase_generate(enum EPieceType piece, uint64_t *res);
+
+/**
+ * @param piece [whitePawns, whiteKing)
+ * @return File name of that bitbase (ie. "KPvK.bb"), or NULL for pieces without one
+ */
+const char *bitbase_file_name(enum EPieceType piece);
+
+/**
+ * Memory-maps every bitbase file in dir (written by `make bitbases`). Missing files are skipped
+ * @param dir
+ * @return Number of bitbases mapped
+ */
+int bitbase_init(const char *dir);
+
+/**
+ * Unmaps every bitbase
+ */
+void bitbase_free(void);
+
+/**
+ * Looks up a king + piece vs king position. Standard chess (and Chess960) only, without castling rights
+ * @param position
+ * @param res Set to 1 (side to move wins), 0 (draw) or -1 (side to move loses)
+ * @return false if position is not covered by a mapped bitbase
+ */
+bool bitbase_probe(FEN position, int *res);
+
+#endif //CHESS_BITBASE_H
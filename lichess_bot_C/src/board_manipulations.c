@@ -13,14 +13,21 @@
 **********************/
 enum enumSquare bitScanForward(uint64_t bb) {
     REQUIRES(bb != 0);
+#if defined(__BMI__)
+    return __builtin_ctzll(bb);  // Single TZCNT instruction
+#else
     const uint64_t debruijn64 = 0x03f79d71b4cb0a89;
     return LS1Bindex64[((bb ^ (bb-1)) * debruijn64) >> 58];
+#endif
 }
 
 
 enum enumSquare bitScanReverse(uint64_t bb) {
-    const uint64_t debruijn64 = 0x03f79d71b4cb0a89;
     REQUIRES(bb != 0);
+#if defined(__LZCNT__)
+    return 63 - __builtin_clzll(bb);  // Single LZCNT instruction
+#else
+    const uint64_t debruijn64 = 0x03f79d71b4cb0a89;
     bb |= bb >> 1;
     bb |= bb >> 2;
     bb |= bb >> 4;
@@ -28,16 +35,21 @@ enum enumSquare bitScanReverse(uint64_t bb) {
     bb |= bb >> 16;
     bb |= bb >> 32;
     return LS1Bindex64[(bb * debruijn64) >> 58];
+#endif
 }
 
 
 int popCount(uint64_t bb) {
+#if defined(__POPCNT__)
+    return __builtin_popcountll(bb);  // Single POPCNT instruction
+#else
     int count = 0;
     while (bb) {
         count++;
         bb &= bb - 1; // reset LS1B
     }
     return count;
+#endif
 }
 
 
@@ -67,19 +79,19 @@ uint64_t antiDiagMask(enum enumSquare sq) {
 
 uint64_t northRay(enum enumSquare sq) {return fileMask(sq) & (-2UL << sq);}
 
-uint64_t southRay(enum enumSquare sq) {return fileMask(sq) & (1UL << sq) - 1;}
+uint64_t southRay(enum enumSquare sq) {return fileMask(sq) & ((1UL << sq) - 1);}
 
 uint64_t eastRay(enum enumSquare sq) {return rankMask(sq) & (-2UL << sq);}
 
-uint64_t westRay(enum enumSquare sq) {return rankMask(sq) & (1UL << sq) - 1;}
+uint64_t westRay(enum enumSquare sq) {return rankMask(sq) & ((1UL << sq) - 1);}
 
 uint64_t northEastRay(enum enumSquare sq) {return diagonalMask(sq) & (-2UL << sq);}
 
-uint64_t southWestRay(enum enumSquare sq) {return diagonalMask(sq) & (1UL << sq) - 1;}
+uint64_t southWestRay(enum enumSquare sq) {return diagonalMask(sq) & ((1UL << sq) - 1);}
 
 uint64_t northWestRay(enum enumSquare sq) {return antiDiagMask(sq) & (-2UL << sq);}
 
-uint64_t southEastRay(enum enumSquare sq) {return antiDiagMask(sq) & (1UL << sq) - 1;}
+uint64_t southEastRay(enum enumSquare sq) {return antiDiagMask(sq) & ((1UL << sq) - 1);}
 
 
 /*********************
@@ -94,11 +106,12 @@ void make_move(uint64_t *BBoard, move m) {
     ASSERT(BBoard[m->piece] & from_bit);  // from index should be occupied
     ASSERT(!(BBoard[m->piece] & to_bit));  // to index should be empty
     BBoard[m->piece] &= ~from_bit;
+    enum EPieceType promotion = m->promotion ? m->promotion : whiteQueens;
     if ((m->piece == whitePawns) && (to_bit & rankMask(a8))) {  // White pawn promotion!
-        BBoard[whiteQueens] |= to_bit;
+        BBoard[promotion] |= to_bit;
     }
     else if ((m->piece == blackPawns) && (to_bit & rankMask(a1))) {  // Black pawn promotion!
-        BBoard[blackQueens] |= to_bit;
+        BBoard[promotion + colorOffset] |= to_bit;
     }
     else {  // Normal move
         BBoard[m->piece] |= to_bit;
@@ -12,6 +12,8 @@
 
 /**********************
  * BASIC BIT OPERATIONS
+ * Each build flavour (see Makefile) compiles these with the matching instruction set.
+ * Generic builds fall back to the portable versions cited below.
 **********************/
 /**
  * Finds index of the first piece on bitboard
@@ -0,0 +1,237 @@
+//
+// Polyglot opening books, memory-mapped once and probed without touching the file system again.
+//
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "lib/contracts.h"
+#include "lib/xalloc.h"
+#include "lib/hmap.h"
+#include "dataStructs.h"
+#include "board_manipulations.h"
+#include "dev_tools.h"
+#include "book.h"
+
+#define BOOK_ENTRY_SIZE 16
+#define MAX_BOOK_MOVES 64  // More entries than any position has legal moves
+#define BOOK_CACHE_SIZE 1024        // Initial capacity: a few games' worth of positions
+#define BOOK_CACHE_MAX (1 << 16)    // Cleared when it holds this many keys, so a long-running bot stays bounded
+
+// Offsets into polyglot_random64
+#define RANDOM_CASTLE 768
+#define RANDOM_EN_PASSANT 772
+#define RANDOM_TURN 780
+
+
+/**********************
+ * POLYGLOT KEY
+**********************/
+uint64_t polyglot_key(FEN position) {
+    REQUIRES(position != NULL);
+    uint64_t key = 0;
+
+    // Polyglot orders pieces as black pawn, white pawn, black knight, white knight, ...
+    for (enum EPieceType piece = whitePawns; piece < blackAll; piece++) {
+        if (piece == whiteAll) continue;
+        int kind = 2 * (piece % colorOffset) + (piece < colorOffset);
+        uint64_t bb = position->BBoard[piece];
+        while (bb) {
+            key ^= polyglot_random64[64 * kind + bitScanForward(bb)];
+            bb &= bb - 1;
+        }
+    }
+
+    if (position->castling & (1UL << g1)) key ^= polyglot_random64[RANDOM_CASTLE + 0];
+    if (position->castling & (1UL << c1)) key ^= polyglot_random64[RANDOM_CASTLE + 1];
+    if (position->castling & (1UL << g8)) key ^= polyglot_random64[RANDOM_CASTLE + 2];
+    if (position->castling & (1UL << c8)) key ^= polyglot_random64[RANDOM_CASTLE + 3];
+
+    // En passant only counts if a pawn of the side to move stands next to the pawn that double-moved
+    if (position->enPassant) {
+        enum enumSquare target = bitScanForward(position->enPassant);
+        uint64_t pushed = position->whiteToMove ? position->enPassant >> 8 : position->enPassant << 8;
+        uint64_t capturers = ((pushed << 1) & not_a_file) | ((pushed >> 1) & not_h_file);
+        uint64_t pawns = position->BBoard[position->whiteToMove ? whitePawns : blackPawns];
+        if (capturers & pawns) key ^= polyglot_random64[RANDOM_EN_PASSANT + target % 8];
+    }
+
+    if (position->whiteToMove) key ^= polyglot_random64[RANDOM_TURN];
+    return key;
+}
+
+
+/**********************
+ * BOOK FILE
+**********************/
+/**
+ * Entries of one key: [first, first + count)
+ */
+struct book_range {
+    size_t first;
+    size_t count;
+};
+
+DEFINE_HMAP(book_ranges, uint64_t, struct book_range, hmap_hash_u64, hmap_eq_u64)
+
+/**
+ * Probed keys, shared by the threads probing the book
+ */
+struct book_cache {
+    pthread_mutex_t lock;
+    struct book_ranges ranges;
+};
+
+
+book book_open(const char *path) {
+    REQUIRES(path != NULL);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0 || st.st_size % BOOK_ENTRY_SIZE != 0) {
+        close(fd);
+        return NULL;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping stays valid after the descriptor is closed
+    if (map == MAP_FAILED) return NULL;
+
+    book b = xmalloc(sizeof(struct polyglot_book));
+    b->entries = map;
+    b->numEntries = st.st_size / BOOK_ENTRY_SIZE;
+    b->mapSize = st.st_size;
+    b->cache = xmalloc(sizeof(struct book_cache));
+    pthread_mutex_init(&b->cache->lock, NULL);
+    book_ranges_init(&b->cache->ranges, BOOK_CACHE_SIZE);
+    return b;
+}
+
+
+void book_close(book b) {
+    if (b == NULL) return;
+    munmap((void *) b->entries, b->mapSize);
+    book_ranges_free(&b->cache->ranges);
+    pthread_mutex_destroy(&b->cache->lock);
+    free(b->cache);
+    free(b);
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Reads an n byte big-endian number
+ */
+static uint64_t _read_be(const unsigned char *p, int n) {
+    uint64_t x = 0;
+    for (int i = 0; i < n; i++) x = (x << 8) | p[i];
+    return x;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Finds the entries of key: from the cache, or else by binary search, whose result is then cached
+ */
+static struct book_range _find_key(book b, uint64_t key) {
+    pthread_mutex_lock(&b->cache->lock);
+    struct book_range *cached = book_ranges_get(&b->cache->ranges, key);
+    struct book_range res;
+    if (cached) res = *cached;
+    else {
+        size_t lo = 0, hi = b->numEntries;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (_read_be(b->entries + mid * BOOK_ENTRY_SIZE, 8) < key) lo = mid + 1;
+            else hi = mid;
+        }
+        res.first = lo;
+        res.count = 0;
+        while (lo + res.count < b->numEntries && _read_be(b->entries + (lo + res.count) * BOOK_ENTRY_SIZE, 8) == key) {
+            res.count++;
+        }
+        if (book_ranges_size(&b->cache->ranges) >= BOOK_CACHE_MAX) book_ranges_clear(&b->cache->ranges);
+        book_ranges_put(&b->cache->ranges, key, res);
+    }
+    pthread_mutex_unlock(&b->cache->lock);
+    return res;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Converts a Polyglot move into UCI format. Polyglot writes castling as king-takes-own-rook
+ */
+static void _move_to_uci(FEN position, uint16_t pg_move, char *res) {
+    enum enumSquare to = pg_move & 63;
+    enum enumSquare from = (pg_move >> 6) & 63;
+    int promotion = (pg_move >> 12) & 7;
+
+    uint64_t kings = position->BBoard[whiteKing] | position->BBoard[blackKing];
+    if ((kings & (1UL << from)) && (from == e1 || from == e8)) {
+        if (to == h1 || to == h8) to = from + 2;
+        else if (to == a1 || to == a8) to = from - 2;
+    }
+
+    enumSquare_to_string(res, from);
+    enumSquare_to_string(res + 2, to);
+    res[4] = promotion ? " nbrq"[promotion] : '\0';
+    res[5] = '\0';
+}
+
+
+bool book_move(book b, FEN position, enum bookSelection selection, int min_weight, uint64_t random, char *res) {
+    REQUIRES(b != NULL && position != NULL && res != NULL);
+    struct book_range range = _find_key(b, polyglot_key(position));
+
+    // Gather candidate moves
+    uint16_t moves[MAX_BOOK_MOVES];
+    uint16_t weights[MAX_BOOK_MOVES];
+    int count = 0;
+    uint64_t total_weight = 0;
+    for (size_t i = range.first; i < range.first + range.count && count < MAX_BOOK_MOVES; i++) {
+        const unsigned char *entry = b->entries + i * BOOK_ENTRY_SIZE;
+        uint16_t weight = _read_be(entry + 10, 2);
+        if (selection != bookWeighted && weight < min_weight) continue;
+        moves[count] = _read_be(entry + 8, 2);
+        weights[count] = weight;
+        total_weight += weight;
+        count++;
+    }
+    if (count == 0 || (selection == bookWeighted && total_weight == 0)) return false;
+
+    int chosen = 0;
+    switch (selection) {
+        case bookBestMove:
+            for (int i = 1; i < count; i++) {
+                if (weights[i] > weights[chosen]) chosen = i;
+            }
+            break;
+        case bookWeighted: {
+            uint64_t pick = random % total_weight;
+            while (pick >= weights[chosen]) pick -= weights[chosen++];
+            break;
+        }
+        case bookUniform:
+            chosen = random % count;
+            break;
+    }
+
+    _move_to_uci(position, moves[chosen], res);
+    return true;
+}
+
+
+bool book_move_fen(book b, const char *fen, int selection, int min_weight, uint64_t random, char *res) {
+    REQUIRES(fen != NULL);
+    struct FEN_info position;
+    if (parse_fen(fen, &position) == NULL) return false;
+    return book_move(b, &position, selection, min_weight, random, res);
+}
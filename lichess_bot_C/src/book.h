@@ -0,0 +1,77 @@
+//
+// Polyglot opening books, memory-mapped once and probed without touching the file system again.
+// Format: http://hgm.nubati.net/book_format.html
+//
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef CHESS_BOOK_H
+#define CHESS_BOOK_H
+
+/**
+ * Book selection strategies, matching the lichess bot's polyglot config
+ */
+enum bookSelection {
+    bookBestMove=0,     // Highest weight
+    bookWeighted=1,     // Random, proportional to weight
+    bookUniform=2       // Random, every entry equally likely
+};
+
+/**
+ * Read-only mapping of a .bin file. Threads may share one book
+ */
+struct polyglot_book {
+    const unsigned char *entries;  // 16 byte big-endian entries, sorted by key
+    size_t numEntries;
+    size_t mapSize;
+    struct book_cache *cache;      // Where each probed key's entries are, so repeated probes skip the search
+};
+typedef struct polyglot_book *book;
+
+/**
+ * 781 random numbers for the Polyglot key, from the format's specification (see polyglot_random.c)
+ */
+extern const uint64_t polyglot_random64[781];
+
+/**
+ * Computes the Polyglot (Zobrist) key of a position
+ * @param position
+ * @return key, as used to index Polyglot books
+ */
+uint64_t polyglot_key(FEN position);
+
+/**
+ * Memory-maps a Polyglot book
+ * @param path to .bin file
+ * @return book, or NULL if the file cannot be opened or is not a whole number of entries
+ */
+book book_open(const char *path);
+
+/**
+ * Unmaps and frees a book
+ * @param b
+ */
+void book_close(book b);
+
+/**
+ * Finds a book move for position, in microseconds (binary search over the mapped entries, skipped for keys probed
+ * before, including the ones the book does not have)
+ * @param b
+ * @param position
+ * @param selection One of enum bookSelection
+ * @param min_weight Entries below this weight are ignored (except by bookWeighted, as python-chess does)
+ * @param random Any random number. Used by the random selections, so the book itself stays stateless
+ * @param res Buffer of at least 6 chars. Receives the move in UCI format (ie. "e2e4", "e7e8q")
+ * @return true if a move was found
+ */
+bool book_move(book b, FEN position, enum bookSelection selection, int min_weight, uint64_t random, char *res);
+
+/**
+ * Same as book_move, for callers holding a FEN string (ie. Python through ctypes)
+ * @return true if a move was found, false if there is none or fen is malformed
+ */
+bool book_move_fen(book b, const char *fen, int selection, int min_weight, uint64_t random, char *res);
+
+#endif //CHESS_BOOK_H
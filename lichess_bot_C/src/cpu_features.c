@@ -0,0 +1,78 @@
+//
+// Runtime CPU-feature detection used to pick the fastest engine build flavour.
+//
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cpu_features.h"
+#include "lib/contracts.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * AVX2 also needs the OS to save YMM registers on context switch (XCR0 bits 1 and 2)
+ */
+static bool _os_supports_avx(void) {
+    uint32_t eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+    if (!(ecx & (1U << 27))) return false;  // OSXSAVE
+    uint32_t xcr0_lo, xcr0_hi;
+    __asm__ volatile ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    return (xcr0_lo & 0x6) == 0x6;
+}
+
+
+static enum cpuFlavour _detect_flavour(void) {
+    uint32_t eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return flavourGeneric;
+    bool popcnt = ecx & (1U << 23);
+    bool fma = ecx & (1U << 12);  // The avx2 flavour is also compiled with -mfma
+    if (!popcnt) return flavourGeneric;
+
+    bool bmi1 = false, bmi2 = false, avx2 = false, lzcnt = false;
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        bmi1 = ebx & (1U << 3);
+        avx2 = ebx & (1U << 5);
+        bmi2 = ebx & (1U << 8);
+    }
+    if (__get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx)) {
+        lzcnt = ecx & (1U << 5);  // ABM
+    }
+
+    if (!(bmi1 && bmi2 && lzcnt)) return flavourPopcnt;
+    if (!(avx2 && fma && _os_supports_avx())) return flavourBMI2;
+    return flavourAVX2;
+}
+#else
+static enum cpuFlavour _detect_flavour(void) {return flavourGeneric;}
+#endif
+
+
+enum cpuFlavour cpu_best_flavour(void) {
+    static int cached = -1;  // Racing writers store the same value, so no lock is needed
+    if (cached < 0) cached = _detect_flavour();
+    ENSURES(0 <= cached && cached < numFlavours);
+    return cached;
+}
+
+
+enum cpuFlavour engine_flavour(void) {
+#if defined(__AVX2__) && defined(__BMI2__)
+    return flavourAVX2;
+#elif defined(__BMI2__)
+    return flavourBMI2;
+#elif defined(__POPCNT__)
+    return flavourPopcnt;
+#else
+    return flavourGeneric;
+#endif
+}
+
+
+const char *cpu_flavour_name(enum cpuFlavour flavour) {
+    REQUIRES(0 <= flavour && flavour < numFlavours);
+    static const char *names[numFlavours] = {"generic", "popcnt", "bmi2", "avx2"};
+    return names[flavour];
+}
@@ -0,0 +1,38 @@
+//
+// Runtime CPU-feature detection used to pick the fastest engine build flavour.
+//
+
+#ifndef CHESS_CPU_FEATURES_H
+#define CHESS_CPU_FEATURES_H
+
+/**
+ * Build flavours, ordered from most portable to most demanding.
+ * Each flavour is compiled from the same sources with different instruction sets (see Makefile)
+ */
+enum cpuFlavour {
+    flavourGeneric=0,  // Portable C: Kernighan popcount, De Bruijn bit scans
+    flavourPopcnt=1,   // POPCNT
+    flavourBMI2=2,     // POPCNT, BMI1 (TZCNT), BMI2, LZCNT
+    flavourAVX2=3,     // Everything above + AVX2, FMA
+    numFlavours=4
+};
+
+/**
+ * Queries cpuid (and the OS-enabled register state for AVX2) once, and caches the answer.
+ * Also built on its own as cpu_features.so, so the lichess bot can ask before loading an engine library
+ * @return Most demanding flavour this CPU can run. Always flavourGeneric on non-x86 hosts
+ */
+enum cpuFlavour cpu_best_flavour(void);
+
+/**
+ * @return Flavour the running code was compiled for
+ */
+enum cpuFlavour engine_flavour(void);
+
+/**
+ * @param flavour
+ * @return Short name used in flavoured file names (ie. "bmi2" for bin/ChessEngine-bmi2.o)
+ */
+const char *cpu_flavour_name(enum cpuFlavour flavour);
+
+#endif //CHESS_CPU_FEATURES_H
@@ -0,0 +1,160 @@
+//
+// Crazyhouse: drop moves from the pockets, capture bookkeeping, and pocket terms for the key and evaluation.
+//
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "lib/contracts.h"
+#include "dataStructs.h"
+#include "board_manipulations.h"
+#include "crazyhouse.h"
+
+#define BACK_RANKS 0xFF000000000000FFUL
+#define KING_DROP_DANGER 6  // Per empty square next to the king, per piece the opponent holds
+
+static const int in_hand_bonus[whiteKing] = {15, 30, 20, 10, 15};  // On top of mg_value, per piece type
+static uint64_t pocket_keys[numPieceTypes][POCKET_MAX + 1];
+static uint64_t promoted_keys[totalSquares];
+static bool keys_ready = false;
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * splitmix64: a fixed sequence, so keys are the same every run (ie. for keys stored in files)
+ */
+static uint64_t _next_random(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15UL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9UL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBUL;
+    return z ^ (z >> 31);
+}
+
+
+void crazyhouse_init(void) {
+    if (keys_ready) return;
+    uint64_t state = 0x6372617A79UL;  // "crazy"
+    for (int piece = 0; piece < numPieceTypes; piece++) {
+        pocket_keys[piece][0] = 0;  // So an empty pocket adds nothing
+        for (int count = 1; count <= POCKET_MAX; count++) pocket_keys[piece][count] = _next_random(&state);
+    }
+    for (int sq = 0; sq < totalSquares; sq++) promoted_keys[sq] = _next_random(&state);
+    keys_ready = true;
+}
+
+
+uint64_t drop_targets(FEN position, enum EPieceType piece) {
+    REQUIRES(position != NULL && piece != whiteAll && piece != blackAll);
+    uint64_t empty = ~(position->BBoard[whiteAll] | position->BBoard[blackAll]);
+    if (piece % colorOffset == whitePawns) empty &= ~BACK_RANKS;
+    return empty;
+}
+
+
+int generate_drops(FEN position, struct move_info *res) {
+    REQUIRES(position != NULL && res != NULL);
+    int n = 0;
+    enum EPieceType first = position->whiteToMove ? whitePawns : blackPawns;
+    for (enum EPieceType piece = first; piece < first + whiteKing; piece++) {
+        if (position->pockets[piece] == 0) continue;
+        uint64_t targets = drop_targets(position, piece);
+        while (targets) {
+            res[n].from = DROP_FROM;
+            res[n].to = bitScanForward(targets);
+            res[n].piece = piece;
+            res[n].promotion = 0;
+            n++;
+            targets &= targets - 1;
+        }
+    }
+    ENSURES(n <= MAX_DROPS);
+    return n;
+}
+
+
+void make_drop(FEN position, move m) {
+    REQUIRES(position != NULL && m != NULL && m->from == DROP_FROM);
+    REQUIRES(position->pockets[m->piece] > 0 && (drop_targets(position, m->piece) >> m->to & 1));
+    uint64_t to_bit = 1UL << m->to;
+    position->BBoard[m->piece] |= to_bit;
+    position->BBoard[m->piece < colorOffset ? whiteAll : blackAll] |= to_bit;
+    position->pockets[m->piece]--;
+}
+
+
+void crazyhouse_pocket(FEN position, enum EPieceType piece, bool promoted) {
+    REQUIRES(position != NULL && piece % colorOffset < whiteKing);
+    int capturer = (piece < colorOffset) ? colorOffset : 0;
+    int type = promoted ? whitePawns : piece % colorOffset;
+    if (position->pockets[capturer + type] < POCKET_MAX) position->pockets[capturer + type]++;
+}
+
+
+void crazyhouse_make_move(FEN position, move m) {
+    REQUIRES(position != NULL && m != NULL && m->from != DROP_FROM);
+    uint64_t from_bit = 1UL << m->from;
+    uint64_t to_bit = 1UL << m->to;
+    enum EPieceType enemy = (m->piece < colorOffset) ? colorOffset : 0;
+
+    for (enum EPieceType piece = enemy; piece < enemy + whiteKing; piece++) {
+        if (!(position->BBoard[piece] & to_bit)) continue;
+        crazyhouse_pocket(position, piece, (position->promoted & to_bit) != 0);
+        break;
+    }
+
+    // Promoted pieces keep their mark when they move, and new queens get one
+    bool promotion = (m->piece % colorOffset == whitePawns) && (to_bit & BACK_RANKS);
+    bool wasPromoted = position->promoted & from_bit;
+    position->promoted &= ~(from_bit | to_bit);
+    if (promotion || wasPromoted) position->promoted |= to_bit;
+
+    make_move(position->BBoard, m);
+}
+
+
+uint64_t crazyhouse_key(FEN position) {
+    REQUIRES(position != NULL);
+    ASSERT(keys_ready);
+    uint64_t key = 0;
+    for (enum EPieceType piece = whitePawns; piece < blackKing; piece++) {
+        if (piece % colorOffset == whiteKing) continue;
+        key ^= pocket_keys[piece][position->pockets[piece]];
+    }
+    uint64_t promoted = position->promoted;
+    while (promoted) {
+        key ^= promoted_keys[bitScanForward(promoted)];
+        promoted &= promoted - 1;
+    }
+    return key;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * @return Squares next to the king (none if there is no king)
+ */
+static uint64_t _king_zone(uint64_t king) {
+    uint64_t sides = ((king << 1) & not_a_file) | ((king >> 1) & not_h_file);
+    uint64_t row = king | sides;
+    return sides | (row << 8) | (row >> 8);
+}
+
+
+int crazyhouse_evaluate(FEN position, int eval) {
+    REQUIRES(position != NULL);
+    int score = 0;  // From white's perspective
+    int white_held = 0, black_held = 0;
+    for (enum EPieceType piece = whitePawns; piece < whiteKing; piece++) {
+        int white = position->pockets[piece];
+        int black = position->pockets[piece + colorOffset];
+        score += (white - black) * (mg_value[piece] + in_hand_bonus[piece]);
+        white_held += white;
+        black_held += black;
+    }
+
+    uint64_t empty = ~(position->BBoard[whiteAll] | position->BBoard[blackAll]);
+    score -= KING_DROP_DANGER * black_held * popCount(_king_zone(position->BBoard[whiteKing]) & empty);
+    score += KING_DROP_DANGER * white_held * popCount(_king_zone(position->BBoard[blackKing]) & empty);
+    return eval + (position->whiteToMove ? score : -score);
+}
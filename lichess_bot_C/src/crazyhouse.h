@@ -0,0 +1,76 @@
+//
+// Crazyhouse: drop moves from the pockets, capture bookkeeping, and pocket terms for the key and evaluation.
+//
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef CHESS_CRAZYHOUSE_H
+#define CHESS_CRAZYHOUSE_H
+
+#define DROP_FROM totalSquares  // move_info.from of a drop, which has no origin square
+#define MAX_DROPS (5 * 64)      // Every piece type in hand onto every square
+
+/**
+ * Fills in the random numbers crazyhouse_key uses. Called by movegen_init
+ */
+void crazyhouse_init(void);
+
+/**
+ * @param position
+ * @param piece Piece type to drop (either colour)
+ * @return Squares it may be dropped on: empty ones, without the first and last ranks for pawns
+ */
+uint64_t drop_targets(FEN position, enum EPieceType piece);
+
+/**
+ * Drops the side to move can make, with the pieces it holds. Like the other move generators these are
+ * pseudo-legal: a drop that fails to block a check still has to be filtered out
+ * @param position
+ * @param res Buffer of at least MAX_DROPS moves
+ * @return Number of moves written to res
+ */
+int generate_drops(FEN position, struct move_info *res);
+
+/**
+ * Places the dropped piece and takes it out of its side's pocket. Does not change the side to move
+ * @param position
+ * @param m A drop (m->from == DROP_FROM) of a piece the mover holds, onto an empty square
+ */
+void make_drop(FEN position, move m);
+
+/**
+ * Puts a captured piece into the pocket of the side that took it
+ * @param position
+ * @param piece The captured piece (either colour, not a king)
+ * @param promoted Whether it was a promoted pawn, which goes back into the pocket as a pawn
+ */
+void crazyhouse_pocket(FEN position, enum EPieceType piece, bool promoted);
+
+/**
+ * make_move for crazyhouse: a captured piece goes into the capturer's pocket (as a pawn if it was promoted),
+ * and promoted pieces stay marked as they move. En passant captures are pocketed by play_move, which removes
+ * the victim before calling this. Does not change the side to move
+ * @param position
+ * @param m
+ */
+void crazyhouse_make_move(FEN position, move m);
+
+/**
+ * Key of the pockets and promoted pieces, which polyglot_key does not cover. history_key XORs it into
+ * polyglot_key, so positions that differ only in hand do not collide in the transposition table or history
+ * @param position
+ * @return 0 for a position with empty pockets and no promoted pieces
+ */
+uint64_t crazyhouse_key(FEN position);
+
+/**
+ * Adds pieces in hand to the evaluation: each is worth a bit more than on the board, since it can be dropped
+ * anywhere. Empty squares next to a king count against it for every piece the opponent holds
+ * @param position
+ * @param eval General (PeSTO) evaluation from the side to move's perspective
+ * @return Evaluation from the side to move's perspective
+ */
+int crazyhouse_evaluate(FEN position, int eval);
+
+#endif //CHESS_CRAZYHOUSE_H
@@ -55,23 +55,49 @@ struct move_info {
     enum enumSquare from;   // index of origin square
     enum enumSquare to;     // index of destination square
     enum EPieceType piece;  // bitboard to manipulate
+    enum EPieceType promotion;  // Pawn reaching the last rank becomes this, in white (ie. whiteKnights). 0: queen
 };
 typedef struct move_info *move;
 
 
+/**
+ * Variant a build plays, chosen at compile time with -DVARIANT=VARIANT_<name> (see variant.h and `make variants`)
+ */
+#define VARIANT_STANDARD 0
+#define VARIANT_CHESS960 1    // Also used for fromPosition: castling with the king and rooks on any file
+#define VARIANT_THREECHECK 2  // Giving a third check wins
+#define VARIANT_KOTH 3        // King of the Hill: a king reaching d4, e4, d5 or e5 wins
+#define VARIANT_CRAZYHOUSE 4  // Captured pieces go into the capturer's pocket, to be dropped back on the board
+
+#ifndef VARIANT
+#define VARIANT VARIANT_STANDARD
+#endif
+
+
 /**
  * FEN info
  */
 struct FEN_info {
-    uint64_t *BBoard;
+    uint64_t BBoard[numPieceTypes];  // Stored inline so a position can live on the stack / in an array
     bool whiteToMove;
-    uint64_t castling;
-    uint64_t enPassant;
+    uint64_t castling;   // King destination squares (g1, c1, g8, c8) of each remaining castling right
+    uint64_t enPassant;  // Target square behind the pawn that just double-moved, or 0
     int halfMove;
     int fullMove;
+    bool crazyhouse;     // Whether the FEN had a pocket field (ie. "[Qp]"), so write_fen writes one back
+    uint8_t pockets[numPieceTypes];  // Crazyhouse pieces in hand, by EPieceType. Only pawns to queens are used
+    uint64_t promoted;   // Crazyhouse pieces that were pawns ("~" in the FEN), which are pocketed as pawns
+#if VARIANT == VARIANT_CHESS960
+    uint64_t castlingRooks;  // Rook of each remaining castling right, which may stand on any file
+#elif VARIANT == VARIANT_THREECHECK
+    uint8_t checksLeft[2];   // Checks white / black still has to give to win ("3+3" in the FEN)
+#endif
 };
 typedef struct FEN_info *FEN;
 
+#define POCKET_MAX 16  // Most pieces of one type a side can hold: every pawn, each promoted and captured
+#define FEN_MAX_LENGTH 192  // 71 board chars, 32 "~" and 62 pocket chars + side, castling, en passant and clocks
+
 
 /**
  * Bit masks that determine whether pieces are in specific ranks / files
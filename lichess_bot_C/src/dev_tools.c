@@ -6,9 +6,13 @@
 #include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
 
 #include "lib/contracts.h"
+#include "lib/xalloc.h"
 #include "dataStructs.h"
+#include "board_manipulations.h"
+#include "dev_tools.h"
 
 /**
  * HELPER FUNCTION LOCAL TO THIS FILE. USE FLIP(sq) IN board_manipulation.h
@@ -82,165 +86,344 @@ void render_all(uint64_t *BBoard) {
 }
 
 
-uint64_t *fen2bit(char *board_fen) {
-    REQUIRES(board_fen != NULL);
+/**
+ * HELPER TABLES LOCAL TO THIS FILE
+ * Maps a FEN piece character to its EPieceType + 1. Every other character maps to 0 (not a piece)
+ */
+static const unsigned char _fen_piece[128] = {
+    ['P'] = whitePawns + 1, ['N'] = whiteKnights + 1, ['B'] = whiteBishops + 1,
+    ['R'] = whiteRooks + 1, ['Q'] = whiteQueens + 1, ['K'] = whiteKing + 1,
+    ['p'] = blackPawns + 1, ['n'] = blackKnights + 1, ['b'] = blackBishops + 1,
+    ['r'] = blackRooks + 1, ['q'] = blackQueens + 1, ['k'] = blackKing + 1,
+};
+static const char *_piece_chars = "PNBRQK?pnbrqk";  // Indexed by EPieceType. '?' is whiteAll
 
-    // Create bitboard
-    uint64_t *bitBoard = calloc(numPieceTypes, sizeof(uint64_t));    // all 0's
-    ASSERT(bitBoard != NULL);
-
-    // Flip the fen board so that a1 is at top left – represented as string array
-    char *token = strtok(board_fen, "/");
-    char *correct_fen[8];
-    ASSERT(correct_fen != NULL);
-    for (int i = 7; i >= 0; i--) {
-        ASSERT(token != NULL);
-        correct_fen[i] = token;
-        token = strtok(NULL, "/");
-    }
 
-    // Assign each chess piece (char) into it's corresponding bitboard
-    for (int i = 0; i < 8; i++) {
-        char bb_index = 8 * i;
-        char *str = correct_fen[i];
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * @return EPieceType of a FEN piece character, or -1 for anything else (including bytes outside ASCII)
+ */
+static int _piece_of(char c) {
+    unsigned char u = (unsigned char) c;
+    return (u < 128) ? _fen_piece[u] - 1 : -1;
+}
 
-        for (int c = 0; str[c] != '\0'; c++) {
-            char curr = (char) str[c];
-            if ('0' < curr && curr <= '8') {    // char is number – empty square
-                bb_index = bb_index + (curr - '0');
-                continue;
-            }
 
-            enum EPieceType currPieceType;
-            enum EPieceType currPieceColor;
-            switch (curr) {
-                case 'P':
-                    currPieceType = whitePawns;
-                    currPieceColor = whiteAll;
-                    break;
-                case 'N':
-                    currPieceType = whiteKnights;
-                    currPieceColor = whiteAll;
-                    break;
-                case 'B':
-                    currPieceType = whiteBishops;
-                    currPieceColor = whiteAll;
-                    break;
-                case 'R':
-                    currPieceType = whiteRooks;
-                    currPieceColor = whiteAll;
-                    break;
-                case 'Q':
-                    currPieceType = whiteQueens;
-                    currPieceColor = whiteAll;
-                    break;
-                case 'K':
-                    currPieceType = whiteKing;
-                    currPieceColor = whiteAll;
-                    break;
-                case 'p':
-                    currPieceType = blackPawns;
-                    currPieceColor = blackAll;
-                    break;
-                case 'n':
-                    currPieceType = blackKnights;
-                    currPieceColor = blackAll;
-                    break;
-                case 'b':
-                    currPieceType = blackBishops;
-                    currPieceColor = blackAll;
-                    break;
-                case 'r':
-                    currPieceType = blackRooks;
-                    currPieceColor = blackAll;
-                    break;
-                case 'q':
-                    currPieceType = blackQueens;
-                    currPieceColor = blackAll;
-                    break;
-                case 'k':
-                    currPieceType = blackKing;
-                    currPieceColor = blackAll;
-                    break;
-                default:
-                    assert(false);  // shouldn't be any other string
-            }
-            ASSERT(0 <= bb_index && bb_index < 64);
-            // printf("currPiece: %c, index: %d\n", curr, bb_index);
-            uint64_t position = ((uint64_t) 1) << bb_index;
-            bitBoard[currPieceType] = bitBoard[currPieceType] | position;
-            bitBoard[currPieceColor] = bitBoard[currPieceColor] | position;
-            bb_index++;
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Parses the board field of a FEN into BBoard (which must be zeroed), in a single left to right pass.
+ * Crazyhouse "~" marks after promoted pieces are added to *promoted (which must be zeroed)
+ * @return Pointer to the first character after the board field (a crazyhouse pocket field may follow, as
+ * "[...]" or as a ninth "/..." rank), or NULL if the field is malformed
+ */
+static const char *_parse_board(const char *c, uint64_t *BBoard, uint64_t *promoted) {
+    int rank = 7, file = 0;  // FEN starts at a8
+    for (; *c != ' ' && *c != '\0' && *c != '['; c++) {
+        if (*c == '/' && rank == 0 && file == 8) break;  // Pocket as a ninth rank
+        if (*c == '/') {
+            if (file != 8 || rank == 0) return NULL;
+            rank--;
+            file = 0;
+        }
+        else if (*c == '~') {  // Previous piece was promoted
+            if (file == 0 || !(((BBoard[whiteAll] | BBoard[blackAll]) >> (8 * rank + file - 1)) & 1)) return NULL;
+            *promoted |= 1UL << (8 * rank + file - 1);
+        }
+        else if ('1' <= *c && *c <= '8') {  // char is number – empty squares
+            file += *c - '0';
+            if (file > 8) return NULL;
+        }
+        else {
+            int piece = _piece_of(*c);
+            if (piece < 0 || file >= 8) return NULL;
+            uint64_t position = 1UL << (8 * rank + file);
+            BBoard[piece] |= position;
+            BBoard[piece < colorOffset ? whiteAll : blackAll] |= position;
+            file++;
         }
-        ASSERT(bb_index == 8*(i+1));
     }
+    if (rank != 0 || file != 8) return NULL;
+    return c;
+}
 
-    ENSURES(bitBoard != NULL);
-    return bitBoard;
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Parses a crazyhouse pocket field, "[QRbp]" or "/QRbp", counting the pieces into pockets (which must be zeroed)
+ * @return Pointer to the first character after the field, or NULL if it is malformed
+ */
+static const char *_parse_pocket(const char *c, uint8_t *pockets) {
+    char close = (*c++ == '[') ? ']' : ' ';
+    for (; *c != close && *c != '\0'; c++) {
+        int piece = _piece_of(*c);
+        if (piece < 0 || piece == whiteKing || piece == blackKing || pockets[piece] == POCKET_MAX) return NULL;
+        pockets[piece]++;
+    }
+    if (close == ']') {
+        if (*c != ']') return NULL;
+        c++;
+    }
+    return c;
+}
+
+
+#if VARIANT == VARIANT_CHESS960
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Reads one X-FEN castling character: K / Q (k / q for black) for the outermost rook on that side of the king,
+ * or the rook's file (A-H / a-h), as Shredder-FEN and X-FEN write inner rooks. Adds the rook to castlingRooks
+ * @return The right, as its king destination square bit, or 0 if there is no such rook
+ */
+static uint64_t _parse_castling_960(char right, FEN tokens) {
+    bool white = ('A' <= right && right <= 'Z');
+    uint64_t rank = white ? 0x00000000000000FFUL : 0xFF00000000000000UL;
+    uint64_t king = tokens->BBoard[white ? whiteKing : blackKing] & rank;
+    uint64_t rooks = tokens->BBoard[white ? whiteRooks : blackRooks] & rank;
+    if (!king) return 0;
+    enum enumSquare kingSq = bitScanForward(king);
+
+    uint64_t rook;
+    char lower = (char) (right | 0x20);
+    if (lower == 'k') rook = rooks & eastRay(kingSq) ? 1UL << bitScanReverse(rooks & eastRay(kingSq)) : 0;
+    else if (lower == 'q') rook = rooks & westRay(kingSq) ? 1UL << bitScanForward(rooks & westRay(kingSq)) : 0;
+    else if ('a' <= lower && lower <= 'h') rook = rooks & fileMask((enum enumSquare) (lower - 'a'));
+    else return 0;
+    if (!rook) return 0;
+
+    tokens->castlingRooks |= rook;
+    bool kingSide = bitScanForward(rook) > kingSq;
+    return 1UL << ((white ? a1 : a8) + (kingSide ? 6 : 2));  // g1, c1, g8 or c8
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Inverse of _parse_castling_960: K / Q / k / q for outermost rooks, file letters for inner ones (X-FEN)
+ * @return Pointer to the character after the last one written
+ */
+static char *_write_castling_960(FEN tokens, char *c) {
+    const enum enumSquare dests[4] = {g1, c1, g8, c8};
+    for (int i = 0; i < 4; i++) {
+        if (!(tokens->castling >> dests[i] & 1)) continue;
+        bool white = i < 2, kingSide = i % 2 == 0;
+        uint64_t rank = white ? 0x00000000000000FFUL : 0xFF00000000000000UL;
+        enum enumSquare kingSq = bitScanForward(tokens->BBoard[white ? whiteKing : blackKing] & rank);
+        uint64_t side = kingSide ? eastRay(kingSq) : westRay(kingSq);
+        uint64_t rooks = tokens->BBoard[white ? whiteRooks : blackRooks] & rank & side;
+        enum enumSquare rook = bitScanForward(tokens->castlingRooks & rank & side);
+        enum enumSquare outermost = kingSide ? bitScanReverse(rooks) : bitScanForward(rooks);
+        char letter = (rook == outermost) ? (kingSide ? 'k' : 'q') : (char) ('a' + rook % 8);
+        *c++ = white ? (char) (letter - 0x20) : letter;
+    }
+    return c;
+}
+#endif
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Reads a non-negative decimal number, and stores it in *res
+ * @return Pointer to the first character after the number, or NULL if there is no number or it overflows an int
+ */
+static const char *_parse_int(const char *c, int *res) {
+    if (*c < '0' || '9' < *c) return NULL;
+    int n = 0;
+    for (; '0' <= *c && *c <= '9'; c++) {
+        if (n > (INT_MAX - (*c - '0')) / 10) return NULL;
+        n = 10 * n + (*c - '0');
+    }
+    *res = n;
+    return c;
 }
 
 
-FEN extract_fen_tokens(char *fen_string) {
-    FEN tokens = malloc(sizeof(struct FEN_info));
+const char *parse_fen(const char *fen_string, FEN tokens) {
+    REQUIRES(fen_string != NULL && tokens != NULL);
+    memset(tokens->BBoard, 0, sizeof(tokens->BBoard));
+    memset(tokens->pockets, 0, sizeof(tokens->pockets));
+    tokens->promoted = 0;
+    const char *c = fen_string;
+    while (*c == ' ') c++;
 
-    // Get board_fen
-    // Store in temporary string and allocate after extracting tokens (strtok() weirdness)
-    fen_string = strtok(fen_string, " ");
-    char *board_fen = malloc(sizeof(char)* (strlen(fen_string) + 1));
-    ASSERT(board_fen != NULL);
-    strcpy(board_fen, fen_string);
+    // Get board_fen, and the pockets if this is a crazyhouse FEN
+    c = _parse_board(c, tokens->BBoard, &tokens->promoted);
+    if (c == NULL) return NULL;
+    tokens->crazyhouse = (*c == '[' || *c == '/');
+    if (tokens->crazyhouse && (c = _parse_pocket(c, tokens->pockets)) == NULL) return NULL;
+    if (*c++ != ' ') return NULL;
 
     // Get active color
-    fen_string = strtok(NULL, " ");
-    if (!strcmp(fen_string, "w")) tokens->whiteToMove = 1;
-    else tokens->whiteToMove = 0;
+    if (*c == 'w') tokens->whiteToMove = true;
+    else if (*c == 'b') tokens->whiteToMove = false;
+    else return NULL;
+    c++;
+    if (*c++ != ' ') return NULL;
 
-    // Get castling rights
-    fen_string = strtok(NULL, " ");
+    // Get castling rights, stored as the king's destination square
     tokens->castling = 0;
-    for (int c = 0; fen_string[c] != '\0'; c++) {
-        ASSERT(c < 4);
-        switch (fen_string[c]) {
-            case '-':  // No castling options
-                break;
-            case 'K':  // King side white
-                tokens->castling += 1UL << g1;
-                break;
-            case 'Q':  // Queen side white
-                tokens->castling += 1UL << c1;
-                break;
-            case 'k':  // King side black
-                tokens->castling += 1UL << g8;
-                break;
-            case 'q':  // Queen side black
-                tokens->castling += 1UL << c8;
-                break;
+#if VARIANT == VARIANT_CHESS960
+    tokens->castlingRooks = 0;
+#endif
+    if (*c == '-') c++;
+    else {
+        for (; *c != ' ' && *c != '\0'; c++) {
+            uint64_t right;
+#if VARIANT == VARIANT_CHESS960
+            if ((right = _parse_castling_960(*c, tokens)) == 0) return NULL;
+#else
+            switch (*c) {
+                case 'K': right = 1UL << g1; break;  // King side white
+                case 'Q': right = 1UL << c1; break;  // Queen side white
+                case 'k': right = 1UL << g8; break;  // King side black
+                case 'q': right = 1UL << c8; break;  // Queen side black
+                default: return NULL;
+            }
+#endif
+            if (tokens->castling & right) return NULL;  // Repeated right
+            tokens->castling |= right;
         }
+        if (tokens->castling == 0) return NULL;
     }
+    if (*c++ != ' ') return NULL;
 
-    // Get En Passant targets
-    fen_string = strtok(NULL, " ");
+    // Get En Passant target – on rank 6 if white is to capture, rank 3 if black is
     tokens->enPassant = 0;
-    if (fen_string[0] == '-') {;}  // No en-passant targets. Do nothing!
-    else {;}  // Todo: There are en-passant targets (ie. e3). Need to convert this
+    if (*c == '-') c++;
+    else {
+        if (c[0] < 'a' || 'h' < c[0]) return NULL;
+        if (c[1] != (tokens->whiteToMove ? '6' : '3')) return NULL;
+        tokens->enPassant = 1UL << (8 * (c[1] - '1') + (c[0] - 'a'));
+        c += 2;
+    }
+
+#if VARIANT == VARIANT_THREECHECK
+    // Get checks each side still has to give, as python-chess writes them ("3+3"). Optional, like the clocks
+    tokens->checksLeft[0] = tokens->checksLeft[1] = 3;
+    if (c[0] == ' ' && '0' <= c[1] && c[1] <= '3' && c[2] == '+' && '0' <= c[3] && c[3] <= '3') {
+        tokens->checksLeft[0] = (uint8_t) (c[1] - '0');
+        tokens->checksLeft[1] = (uint8_t) (c[3] - '0');
+        c += 4;
+    }
+#endif
+
+    // Get halfmoves and fullmoves. Both are optional, since EPD records leave them out
+    tokens->halfMove = 0;
+    tokens->fullMove = 1;
+    const char *clock = c;
+    while (*clock == ' ') clock++;
+    if ('0' <= *clock && *clock <= '9') {
+        if ((c = _parse_int(clock, &tokens->halfMove)) == NULL) return NULL;  // Too large for an int
+        clock = c;
+        while (*clock == ' ') clock++;
+        if ('0' <= *clock && *clock <= '9' && (c = _parse_int(clock, &tokens->fullMove)) == NULL) return NULL;
+    }
+
+    if (*c != ' ' && *c != '\0' && *c != '\n' && *c != '\r') return NULL;  // Trailing junk in last field
+    return c;
+}
+
+
+int write_fen(FEN tokens, char *res) {
+    REQUIRES(tokens != NULL && res != NULL);
+
+    // Mailbox of piece characters, built one set bit at a time
+    char mailbox[64];
+    memset(mailbox, 0, sizeof(mailbox));
+    for (enum EPieceType piece = whitePawns; piece < blackAll; piece++) {
+        if (piece == whiteAll) continue;
+        uint64_t bb = tokens->BBoard[piece];
+        while (bb) {
+            int sq = bitScanForward(bb);
+            mailbox[sq] = _piece_chars[piece];
+            bb &= bb - 1;
+        }
+    }
+
+    // Board, from a8 to h1
+    char *c = res;
+    for (int rank = 7; rank >= 0; rank--) {
+        int empty = 0;
+        for (int file = 0; file < 8; file++) {
+            char piece = mailbox[8 * rank + file];
+            if (!piece) {
+                empty++;
+                continue;
+            }
+            if (empty) *c++ = (char) ('0' + empty);
+            empty = 0;
+            *c++ = piece;
+            if (tokens->promoted >> (8 * rank + file) & 1) *c++ = '~';
+        }
+        if (empty) *c++ = (char) ('0' + empty);
+        if (rank) *c++ = '/';
+    }
+
+    // Crazyhouse pockets, strongest pieces first and white before black, as lichess writes them
+    if (tokens->crazyhouse) {
+        *c++ = '[';
+        for (int color = 0; color <= colorOffset; color += colorOffset) {
+            for (enum EPieceType piece = whiteQueens; (int) piece >= whitePawns; piece--) {
+                for (int i = 0; i < tokens->pockets[piece + color]; i++) *c++ = _piece_chars[piece + color];
+            }
+        }
+        *c++ = ']';
+    }
+
+    *c++ = ' ';
+    *c++ = tokens->whiteToMove ? 'w' : 'b';
+
+    *c++ = ' ';
+#if VARIANT == VARIANT_CHESS960
+    c = _write_castling_960(tokens, c);
+#else
+    if (tokens->castling & (1UL << g1)) *c++ = 'K';
+    if (tokens->castling & (1UL << c1)) *c++ = 'Q';
+    if (tokens->castling & (1UL << g8)) *c++ = 'k';
+    if (tokens->castling & (1UL << c8)) *c++ = 'q';
+#endif
+    if (c[-1] == ' ') *c++ = '-';
+
+    *c++ = ' ';
+    if (tokens->enPassant) {
+        enumSquare_to_string(c, bitScanForward(tokens->enPassant));
+        c += 2;
+    }
+    else *c++ = '-';
+
+#if VARIANT == VARIANT_THREECHECK
+    c += snprintf(c, FEN_MAX_LENGTH - (c - res), " %d+%d", tokens->checksLeft[0], tokens->checksLeft[1]);
+#endif
+    c += snprintf(c, FEN_MAX_LENGTH - (c - res), " %d %d", tokens->halfMove, tokens->fullMove);
+    ENSURES(c - res < FEN_MAX_LENGTH);
+    return (int) (c - res);
+}
 
-    // Get halfmoves - draw occurs if 50 halfmoves occur with no piece capture or pawn movement
-    fen_string = strtok(NULL, " ");
-    tokens->halfMove = atoi(fen_string);  // At most 2 chars
 
-    // Get fullmoves - has no significance really
-    fen_string = strtok(NULL, " ");
-    tokens->fullMove = atoi(fen_string);  // At most 2 chars
+uint64_t *fen2bit(const char *board_fen) {
+    REQUIRES(board_fen != NULL);
+
+    // Create bitboard
+    uint64_t *bitBoard = xcalloc(numPieceTypes, sizeof(uint64_t));    // all 0's
+    uint64_t promoted = 0;
+    const char *end = _parse_board(board_fen, bitBoard, &promoted);
+    ASSERT(end != NULL);  // shouldn't be any malformed board
+    (void) end;
+
+    ENSURES(bitBoard != NULL);
+    return bitBoard;
+}
 
-    ASSERT(fen_string != NULL);
 
-    tokens->BBoard = fen2bit(board_fen);
+FEN extract_fen_tokens(const char *fen_string) {
+    FEN tokens = xmalloc(sizeof(struct FEN_info));
+    const char *end = parse_fen(fen_string, tokens);
+    ASSERT(end != NULL);
+    (void) end;
     return tokens;
 }
 
 
 void free_tokens(FEN tokens) {
-    free(tokens->BBoard);
     free(tokens);
 }
 
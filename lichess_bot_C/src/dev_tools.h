@@ -30,20 +30,41 @@ PYTHON AND LICHESS API TOOLS
 
 /**
  * Converts board_fen string into bitboard array. Uses Little-Endian Rank-File Mapping
+ * board_fen is not modified
  * @param board_fen
- * @return bitboards corresponding to enum EPieceType
+ * @return bitboards corresponding to enum EPieceType. Caller frees
  * @cite: https://www.chessprogramming.org/Square_Mapping_Considerations#Little-Endian_Rank-File_Mapping
  */
-uint64_t *fen2bit(char *board_fen);
+uint64_t *fen2bit(const char *board_fen);
 
 
 /**
  * Gets all information from a FEN string, as specified here: https://www.chess.com/terms/fen-chess
- * Initializes and stores all information in a FEN struct pointer
- * @param fen_string
- * @return FEN struct pointer (as declared in datastructs.h)
+ * Single pass, reentrant and allocation-free, so positions can be parsed in parallel.
+ * The halfmove and fullmove clocks are optional (default 0 and 1), so EPD records parse too.
+ * Crazyhouse FENs, with a pocket field ("[Qp]" or a ninth rank) and "~" after promoted pieces, are read too
+ * @param fen_string Not modified
+ * @param tokens Caller-provided position that is filled in
+ * @return Pointer to the first character after the FEN (ie. EPD opcodes), or NULL if the FEN is malformed
  */
-FEN extract_fen_tokens(char *fen_string);
+const char *parse_fen(const char *fen_string, FEN tokens);
+
+
+/**
+ * Inverse of parse_fen
+ * @param tokens
+ * @param res Buffer of at least FEN_MAX_LENGTH chars. Will be NUL-terminated
+ * @return Length of the FEN written to res
+ */
+int write_fen(FEN tokens, char *res);
+
+
+/**
+ * Heap-allocating wrapper around parse_fen
+ * @param fen_string Not modified
+ * @return FEN struct pointer (as declared in datastructs.h). Free with free_tokens
+ */
+FEN extract_fen_tokens(const char *fen_string);
 
 
 /**
@@ -0,0 +1,65 @@
+//
+// Static evaluation: tapered PeSTO piece values and piece square tables, corrected by material signature.
+//
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "lib/contracts.h"
+#include "dataStructs.h"
+#include "board_manipulations.h"
+#include "material.h"
+#include "variant.h"
+#include "crazyhouse.h"
+#include "evaluation.h"
+
+#define MAX_PHASE 24  // Opening material: every piece's gamePhaseInc summed
+
+static bool initialized = false;
+
+
+void evaluation_init(void) {
+    if (initialized) return;
+    for (enum EPieceType piece = whitePawns; piece < whiteAll; piece++) {
+        for (enum enumSquare sq = a1; sq < totalSquares; sq++) {
+            // The tables are drawn from white's side with a8 first, so white reads them flipped
+            mg_table[piece][sq] = mg_value[piece] + mg_pesto_table[piece][FLIP(sq)];
+            eg_table[piece][sq] = eg_value[piece] + eg_pesto_table[piece][FLIP(sq)];
+            mg_table[piece + colorOffset][sq] = mg_value[piece] + mg_pesto_table[piece][sq];
+            eg_table[piece + colorOffset][sq] = eg_value[piece] + eg_pesto_table[piece][sq];
+        }
+    }
+    material_init();
+    initialized = true;
+}
+
+
+int evaluate(FEN position) {
+    REQUIRES(position != NULL && initialized);
+    int mg[2] = {0, 0}, eg[2] = {0, 0};  // [white, black]
+    int phase = 0;
+    for (enum EPieceType piece = whitePawns; piece < blackAll; piece++) {
+        if (piece == whiteAll) continue;
+        int side = piece / colorOffset;
+        uint64_t bb = position->BBoard[piece];
+        while (bb) {
+            enum enumSquare sq = bitScanForward(bb);
+            bb &= bb - 1;
+            mg[side] += mg_table[piece][sq];
+            eg[side] += eg_table[piece][sq];
+            phase += gamePhaseInc[piece % colorOffset];
+        }
+    }
+    if (phase > MAX_PHASE) phase = MAX_PHASE;  // Early promotions
+
+    int us = !position->whiteToMove;
+    int mgScore = mg[us] - mg[!us], egScore = eg[us] - eg[!us];
+    int eval = (mgScore * phase + egScore * (MAX_PHASE - phase)) / MAX_PHASE;
+
+    // Piece-count corrections: imbalance, dead draws and known endgames (see material.h). None of them hold
+    // in crazyhouse, where captured pieces come back as drops; pieces in hand are scored instead
+    if (variant_crazyhouse(position)) eval = crazyhouse_evaluate(position, eval);
+    else eval = material_evaluate(position, material_probe(material_key(position->BBoard)), eval);
+    return variant_evaluate(position, eval);
+}
@@ -0,0 +1,22 @@
+//
+// Static evaluation: tapered PeSTO piece values and piece square tables, corrected by material signature.
+//
+
+#include <stdbool.h>
+
+#ifndef CHESS_EVALUATION_H
+#define CHESS_EVALUATION_H
+
+/**
+ * Fills mg_table / eg_table (see dataStructs.h) from the PeSTO tables, and the material table (see material.h).
+ * Call once at startup, before evaluate
+ */
+void evaluation_init(void);
+
+/**
+ * @param position
+ * @return Evaluation in centipawns from the side to move's perspective
+ */
+int evaluate(FEN position);
+
+#endif //CHESS_EVALUATION_H
@@ -0,0 +1,106 @@
+//
+// Position key history, for detecting repetitions and other draws during search.
+//
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "lib/contracts.h"
+#include "dataStructs.h"
+#include "board_manipulations.h"
+#include "book.h"
+#include "crazyhouse.h"
+#include "variant.h"
+#include "history.h"
+
+#define LIGHT_SQUARES 0x55AA55AA55AA55AAUL
+#define MAX_GAME_KEYS (MAX_GAME_PLY / 2)  // Leaves the other half for the search
+
+static struct game_history game;
+
+
+void history_set_game(const uint64_t *keys, int n) {
+    REQUIRES(n >= 0 && (n == 0 || keys != NULL));
+    if (n > MAX_GAME_KEYS) {  // Only the most recent positions can still repeat
+        keys += n - MAX_GAME_KEYS;
+        n = MAX_GAME_KEYS;
+    }
+    memcpy(game.keys, keys, n * sizeof(uint64_t));
+    game.length = n;
+}
+
+
+uint64_t history_key(FEN position) {
+    REQUIRES(position != NULL);
+    uint64_t key = polyglot_key(position);
+    return variant_crazyhouse(position) ? key ^ crazyhouse_key(position) : key;
+}
+
+
+void history_start(history h, uint64_t rootKey) {
+    REQUIRES(h != NULL);
+    memcpy(h->keys, game.keys, game.length * sizeof(uint64_t));
+    h->length = game.length;
+    h->root = game.length;
+    history_push(h, rootKey);
+}
+
+
+void history_push(history h, uint64_t key) {
+    REQUIRES(h != NULL && h->length < MAX_GAME_PLY);
+    h->keys[h->length++] = key;
+}
+
+
+void history_pop(history h) {
+    REQUIRES(h != NULL && h->length > 0);
+    h->length--;
+}
+
+
+bool history_is_repetition(history h, int halfMove) {
+    REQUIRES(h != NULL && h->length > 0);
+    int top = h->length - 1;
+    int oldest = top - halfMove;
+    if (oldest < 0) oldest = 0;
+
+    // Same side to move means an even distance, and it takes at least 4 plies to get back
+    int before_root = 0;
+    for (int i = top - 4; i >= oldest; i -= 2) {
+        if (h->keys[i] != h->keys[top]) continue;
+        if (i >= h->root || ++before_root == 2) return true;
+    }
+    return false;
+}
+
+
+bool insufficient_material(const uint64_t *BBoard) {
+    uint64_t heavy = BBoard[whitePawns] | BBoard[whiteRooks] | BBoard[whiteQueens]
+                     | BBoard[blackPawns] | BBoard[blackRooks] | BBoard[blackQueens];
+    if (heavy) return false;
+
+    uint64_t knights = BBoard[whiteKnights] | BBoard[blackKnights];
+    uint64_t bishops = BBoard[whiteBishops] | BBoard[blackBishops];
+    if (!knights) {
+        return !(bishops & LIGHT_SQUARES) || !(bishops & ~LIGHT_SQUARES);
+    }
+    return !bishops && popCount(knights) == 1;
+}
+
+
+bool history_is_draw(history h, FEN position) {
+    REQUIRES(h != NULL && position != NULL);
+    if (position->halfMove >= 100) return true;
+    if (history_is_repetition(h, position->halfMove)) return true;
+    if (variant_crazyhouse(position)) {
+        for (enum EPieceType piece = whitePawns; piece < numPieceTypes; piece++) {
+            if (position->pockets[piece]) return false;
+        }
+    }
+#if VARIANT == VARIANT_KOTH || VARIANT == VARIANT_THREECHECK
+    return false;  // A lone king can still walk to the hill, and a lone minor piece can still give three checks
+#else
+    return insufficient_material(position->BBoard);
+#endif
+}
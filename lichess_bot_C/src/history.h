@@ -0,0 +1,87 @@
+//
+// Position key history, for detecting repetitions and other draws during search.
+//
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef CHESS_HISTORY_H
+#define CHESS_HISTORY_H
+
+#define MAX_GAME_PLY 1024  // Game plies before the root plus search plies below it
+
+/**
+ * Ply-indexed stack of position keys (history_key). Bottom holds the game before the root, as given by
+ * history_set_game. Each search thread pushes / pops its own copy as it makes / unmakes moves
+ */
+struct game_history {
+    uint64_t keys[MAX_GAME_PLY];
+    int length;
+    int root;  // Index of the search's root
+};
+typedef struct game_history *history;
+
+/**
+ * Stores the positions played before the next search's root. Exported for the Python (ctypes) side,
+ * which calls it before lichess()
+ * @param keys history_key of each earlier position (polyglot_key outside crazyhouse), oldest first, not including
+ * the root. Positions before the last capture or pawn move may be left out, they can never repeat
+ * @param n Number of keys
+ */
+void history_set_game(const uint64_t *keys, int n);
+
+/**
+ * Key the search identifies positions by, in the history and the transposition table: polyglot_key, with the
+ * pockets and promoted pieces (crazyhouse_key) folded in for crazyhouse positions in the Crazyhouse build
+ * @param position
+ * @return
+ */
+uint64_t history_key(FEN position);
+
+/**
+ * Starts a search thread's stack: the stored game, then the root
+ * @param h
+ * @param rootKey history_key of the root
+ */
+void history_start(history h, uint64_t rootKey);
+
+/**
+ * @param h
+ * @param key Key of the position just reached
+ */
+void history_push(history h, uint64_t key);
+
+/**
+ * @param h
+ */
+void history_pop(history h);
+
+/**
+ * Checks whether the top position is a draw by repetition. A single repetition of a position after the root already
+ * counts: whichever side could avoid it would have, so nothing is gained by searching it out.
+ * Positions from before the root must have occurred twice, as in the real threefold rule
+ * @param h
+ * @param halfMove Plies since the last capture or pawn move. Earlier positions cannot repeat the top one
+ * @return true if the top position is a repetition
+ */
+bool history_is_repetition(history h, int halfMove);
+
+/**
+ * @param BBoard
+ * @return true if neither side can possibly mate (KvK, KNvK, KBvK, and bishops only, all on one square colour)
+ */
+bool insufficient_material(const uint64_t *BBoard);
+
+/**
+ * Everything the search can score as a draw without searching: repetitions, the 50-move rule and
+ * insufficient material (crazyhouse: with nothing in either pocket, as pieces in hand can still be dropped; never in
+ * King of the Hill or Three-check, where bare kings can still reach the hill or pieces give check).
+ * Checkmate on the 100th ply takes precedence over the 50-move rule; the caller must handle that if it needs to
+ * be exact
+ * @param h Stack with position's key on top
+ * @param position
+ * @return true if position is a draw
+ */
+bool history_is_draw(history h, FEN position);
+
+#endif //CHESS_HISTORY_H
@@ -0,0 +1,61 @@
+/* Arena (bump-pointer) allocation
+ * See arena.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "contracts.h"
+#include "xalloc.h"
+#include "arena.h"
+
+void arena_init(arena_t A, size_t size) {
+  REQUIRES(A != NULL && size > 0);
+  A->base = xmalloc(size);
+  A->size = size;
+  A->used = 0;
+  A->highWater = 0;
+}
+
+void* arena_alloc(arena_t A, size_t size, size_t align) {
+  REQUIRES(A != NULL && A->base != NULL);
+  REQUIRES(align > 0 && (align & (align - 1)) == 0);
+  uintptr_t start = ((uintptr_t)A->base + A->used + align - 1) & ~(uintptr_t)(align - 1);
+  size_t offset = start - (uintptr_t)A->base;
+  if (offset > A->size || size > A->size - offset) {
+    fprintf(stderr, "arena of %zu bytes exhausted\n", A->size);
+    abort();
+  }
+  A->used = offset + size;
+  if (A->used > A->highWater) A->highWater = A->used;
+  return A->base + offset;
+}
+
+void* arena_calloc(arena_t A, size_t size, size_t align) {
+  void* p = arena_alloc(A, size, align);
+  memset(p, 0, size);
+  return p;
+}
+
+size_t arena_mark(arena_t A) {
+  REQUIRES(A != NULL);
+  return A->used;
+}
+
+void arena_release(arena_t A, size_t mark) {
+  REQUIRES(A != NULL && mark <= A->used);
+  A->used = mark;
+}
+
+void arena_reset(arena_t A) {
+  REQUIRES(A != NULL);
+  A->used = 0;
+}
+
+void arena_free(arena_t A) {
+  REQUIRES(A != NULL);
+  free(A->base);
+  A->base = NULL;
+  A->size = A->used = 0;
+}
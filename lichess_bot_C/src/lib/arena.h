@@ -0,0 +1,58 @@
+/* Arena (bump-pointer) allocation
+ * One block is reserved up front; allocations just advance a pointer,
+ * and everything is released at once by resetting the arena. Not
+ * thread-safe: give every thread its own arena. Like xmalloc, aborts
+ * when the arena is exhausted instead of returning NULL.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+struct arena {
+  char* base;
+  size_t size;       // Bytes reserved
+  size_t used;       // Bytes handed out since the last reset
+  size_t highWater;  // Most bytes ever in use, for sizing the arena
+};
+typedef struct arena* arena_t;
+
+/* arena_init(A, size) reserves size bytes for A, the only call that
+ * goes to the general-purpose allocator.
+ */
+void arena_init(arena_t A, size_t size);
+
+/* arena_alloc(A, size, align) returns size bytes aligned to align (a
+ * power of two), uninitialized.
+ */
+void* arena_alloc(arena_t A, size_t size, size_t align);
+
+/* arena_calloc(A, size, align) is arena_alloc, zeroed.
+ */
+void* arena_calloc(arena_t A, size_t size, size_t align);
+
+/* arena_mark(A) / arena_release(A, mark) free everything allocated
+ * after the mark, ie. per-ply scratch that is dropped on unmake.
+ */
+size_t arena_mark(arena_t A);
+void arena_release(arena_t A, size_t mark);
+
+/* arena_reset(A) frees every allocation, ie. between searches.
+ */
+void arena_reset(arena_t A);
+
+/* arena_free(A) returns the reserved block to the system.
+ */
+void arena_free(arena_t A);
+
+/* Typed helper: ARENA_NEW(A, struct move_info, 256) is an array of 256
+ * uninitialized moves. ARENA_NEW0 zeroes them.
+ */
+#define ARENA_NEW(A, type, n) \
+  ((type*)arena_alloc((A), (n) * sizeof(type), _Alignof(type)))
+#define ARENA_NEW0(A, type, n) \
+  ((type*)arena_calloc((A), (n) * sizeof(type), _Alignof(type)))
+
+#endif
@@ -8,6 +8,9 @@
  * 15-122 Principles of Imperative Computation
  */
 
+#include <stdlib.h>
+#include <limits.h>
+#include <assert.h>
 #include "hdict.h"
 
 /******************************/
@@ -97,8 +100,10 @@ void hdict_free(hdict *H) {
         while (node != NULL) {
             chain *tmp = node->next;
             free(node);
+            node = tmp;
         }
     }
+    free(H->table);
     free(H);
     return;
 }
@@ -135,7 +140,6 @@ void hdict_resize(hdict* H, int new_capacity)
 //@ensures is_hdict(H);
 //@ensures H->capacity == new_capacity;
 {
-  printf("(resizing ht to capacity %d\n", new_capacity);
   chain** old_table = H->table;
   chain** new_table = calloc(sizeof(chain*), new_capacity);
   /* new_table is initialized to all NULL */
@@ -155,6 +159,7 @@ void hdict_resize(hdict* H, int new_capacity)
     }
   /* change ht H in place */
   /* H->size remains unchanged */
+  free(old_table);
   H->capacity = new_capacity;
   H->table = new_table;
   return;
@@ -192,9 +197,9 @@ void hdict_insert(hdict* H, entry e)
   (H->size)++;
 
   /* resize hash table if load factor would be > 1 */
-  if (H->size > H->capacity && H->capacity < int_max()/2) {
+  if (H->size > H->capacity && H->capacity < INT_MAX/2) {
     /* load factor > 1 */
-    assert(H->capacity < int_max()/2);
+    assert(H->capacity < INT_MAX/2);
     hdict_resize(H, 2*H->capacity);
   }
 
@@ -206,7 +211,7 @@ void hdict_stats(hdict* H)
 //@requires is_hdict(H);
 {
   int max = 0;
-  int *A = malloc(sizeof(int), 11);
+  int *A = calloc(11, sizeof(int));
   for(int i = 0; i < H->capacity; i++) {
     int j = chain_length(H->table[i]);
     if (j > 9) A[10]++;
@@ -220,6 +225,7 @@ void hdict_stats(hdict* H)
   }
   printf("...10+: %d\n", A[10]);
   printf("Longest chain: %d\n", max);
+  free(A);
 }
 
 void hdict_print(hdict* H,
@@ -230,7 +236,7 @@ void hdict_print(hdict* H,
   for(int i = 0; i < H->capacity; i++)
     for (chain* p = H->table[i]; p != NULL; p=p->next) {
       (*print_key)(entry_key(H, p->data));
-      flush();
+      fflush(stdout);
       printf(" => ");
       (*print_entry)(p->data);
       printf("\n");
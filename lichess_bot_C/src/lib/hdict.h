@@ -27,6 +27,7 @@ typedef void entry_print_fn(entry e)         // Supplied by client
 /**************************/
 
 // Client-side type
+typedef struct hdict_header hdict;
 typedef hdict* hdict_t;  // typedef ______* hdict_t;
 
 hdict_t hdict_new(int capacity,
@@ -43,6 +44,8 @@ entry hdict_lookup(hdict_t H, key k)             /* O(1) avg. */
 void hdict_insert(hdict_t H, entry e)            /* O(1) avg. */
 /*@requires H != NULL && e != NULL; @*/ ;
 
+void hdict_free(hdict_t H);  /* Frees the chains, not the entries */
+
 int hdict_size(hdict_t H)                        /* O(1) */
 /*@requires H != NULL; @*/
 /*@ensures \result >= 0; @*/ ;
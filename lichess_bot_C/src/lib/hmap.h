@@ -0,0 +1,218 @@
+/* Open-addressing hash maps with inline keys and values
+ * SwissTable layout: one control byte per slot (empty, moved, or 7 bits
+ * of the hash), probed 16 at a time with SSE2 where available. Keys and
+ * values are stored by value, so there is no allocation per insert.
+ * Growth is incremental: the old table is migrated a few slots per call
+ * instead of all at once, so no single insert pays for a full rehash.
+ *
+ * Usage, for a map from uint64_t to int named bookcache:
+ *   DEFINE_HMAP(bookcache, uint64_t, int, hmap_hash_u64, hmap_eq_u64)
+ *   struct bookcache m;
+ *   bookcache_init(&m, 1024);
+ *   bookcache_put(&m, key, 3);
+ *   int* v = bookcache_get(&m, key);   // NULL if absent
+ *   bookcache_free(&m);
+ * hash(K) returns uint64_t, eq(K, K) returns bool. Not thread-safe.
+ * There is no erase: the maps back caches, which are cleared as a whole.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "xalloc.h"
+#include "contracts.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#ifndef _HMAP_H_
+#define _HMAP_H_
+
+#define HMAP_GROUP 16
+#define HMAP_EMPTY ((uint8_t)0x80)
+#define HMAP_MOVED ((uint8_t)0xFE)  // Migrated to the new table; still part of probe chains
+#define HMAP_MIGRATE_STEP 64        // Old slots moved per call while growing
+
+/* Bit i set if control byte i of the group equals b */
+static inline uint32_t hmap_group_match(const uint8_t* ctrl, uint8_t b) {
+#ifdef __SSE2__
+  __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+  return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)b)));
+#else
+  uint32_t res = 0;
+  for (int i = 0; i < HMAP_GROUP; i++) res |= (uint32_t)(ctrl[i] == b) << i;
+  return res;
+#endif
+}
+
+/* Finalizer of MurmurHash3: spreads every key bit over the whole hash */
+static inline uint64_t hmap_hash_u64(uint64_t k) {
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  return k ^ (k >> 33);
+}
+
+static inline bool hmap_eq_u64(uint64_t a, uint64_t b) {
+  return a == b;
+}
+
+#define DEFINE_HMAP(name, K, V, hash_fn, eq_fn)                                 \
+struct name##_slot { K key; V value; };                                         \
+struct name {                                                                   \
+  uint8_t* ctrl;                    /* capacity control bytes */                \
+  struct name##_slot* slots;                                                    \
+  size_t capacity;                  /* power of two, >= HMAP_GROUP */           \
+  size_t size;                      /* entries in both tables */                \
+  size_t growthLeft;                /* inserts before the next growth */        \
+  uint8_t* oldCtrl;                 /* table being migrated, or NULL */         \
+  struct name##_slot* oldSlots;                                                 \
+  size_t oldCapacity;                                                           \
+  size_t migrated;                  /* old slots already visited */             \
+};                                                                              \
+                                                                                \
+static inline void name##_alloc_table(struct name* M, size_t capacity) {        \
+  M->ctrl = xmalloc(capacity);                                                  \
+  memset(M->ctrl, HMAP_EMPTY, capacity);                                        \
+  M->slots = xmalloc(capacity * sizeof(struct name##_slot));                    \
+  M->capacity = capacity;                                                       \
+  M->growthLeft = capacity - capacity / 8;  /* max load factor 7/8 */           \
+}                                                                               \
+                                                                                \
+static inline void name##_init(struct name* M, size_t capacity) {               \
+  REQUIRES(M != NULL);                                                          \
+  size_t c = HMAP_GROUP;                                                        \
+  while (c < capacity) c *= 2;                                                  \
+  name##_alloc_table(M, c);                                                     \
+  M->size = 0;                                                                  \
+  M->oldCtrl = NULL;                                                            \
+  M->oldSlots = NULL;                                                           \
+  M->oldCapacity = M->migrated = 0;                                             \
+}                                                                               \
+                                                                                \
+/* Slot index of key k in (ctrl, capacity), or SIZE_MAX */                      \
+static inline size_t name##_find_in(const uint8_t* ctrl,                        \
+    const struct name##_slot* slots, size_t capacity, K k, uint64_t h) {        \
+  size_t groups = capacity / HMAP_GROUP;                                        \
+  size_t g = (h >> 7) & (groups - 1);                                           \
+  for (size_t step = 1; step <= groups; step++) {                               \
+    const uint8_t* c = ctrl + g * HMAP_GROUP;                                   \
+    for (uint32_t m = hmap_group_match(c, (uint8_t)(h & 0x7F)); m; m &= m - 1) { \
+      size_t i = g * HMAP_GROUP + __builtin_ctz(m);                             \
+      if (eq_fn(slots[i].key, k)) return i;                                     \
+    }                                                                           \
+    if (hmap_group_match(c, HMAP_EMPTY)) return SIZE_MAX;                       \
+    g = (g + step) & (groups - 1);  /* triangular: visits every group */        \
+  }                                                                             \
+  return SIZE_MAX;                                                              \
+}                                                                               \
+                                                                                \
+/* First empty slot on key's probe sequence. The table must have one */         \
+static inline size_t name##_free_slot(const uint8_t* ctrl, size_t capacity,     \
+                                      uint64_t h) {                             \
+  size_t groups = capacity / HMAP_GROUP;                                        \
+  size_t g = (h >> 7) & (groups - 1);                                           \
+  for (size_t step = 1;; step++) {                                              \
+    uint32_t m = hmap_group_match(ctrl + g * HMAP_GROUP, HMAP_EMPTY);           \
+    if (m) return g * HMAP_GROUP + __builtin_ctz(m);                            \
+    g = (g + step) & (groups - 1);                                              \
+  }                                                                             \
+}                                                                               \
+                                                                                \
+static inline void name##_place(struct name* M, K k, V value, uint64_t h) {     \
+  size_t i = name##_free_slot(M->ctrl, M->capacity, h);                         \
+  M->ctrl[i] = (uint8_t)(h & 0x7F);                                             \
+  M->slots[i].key = k;                                                          \
+  M->slots[i].value = value;                                                    \
+  M->growthLeft--;                                                              \
+}                                                                               \
+                                                                                \
+/* Moves up to n old slots into the new table; frees the old one at the end */  \
+static inline void name##_migrate(struct name* M, size_t n) {                   \
+  for (; n > 0 && M->migrated < M->oldCapacity; n--, M->migrated++) {           \
+    size_t i = M->migrated;                                                     \
+    if (M->oldCtrl[i] & 0x80) continue;  /* empty or moved */                   \
+    struct name##_slot* s = &M->oldSlots[i];                                    \
+    name##_place(M, s->key, s->value, hash_fn(s->key));                         \
+    M->oldCtrl[i] = HMAP_MOVED;                                                 \
+  }                                                                             \
+  if (M->oldCtrl != NULL && M->migrated == M->oldCapacity) {                    \
+    free(M->oldCtrl);                                                           \
+    free(M->oldSlots);                                                          \
+    M->oldCtrl = NULL;                                                          \
+    M->oldSlots = NULL;                                                         \
+    M->oldCapacity = M->migrated = 0;                                           \
+  }                                                                             \
+}                                                                               \
+                                                                                \
+static inline void name##_grow(struct name* M) {                                \
+  name##_migrate(M, SIZE_MAX);  /* finish any earlier growth first */           \
+  M->oldCtrl = M->ctrl;                                                         \
+  M->oldSlots = M->slots;                                                       \
+  M->oldCapacity = M->capacity;                                                 \
+  M->migrated = 0;                                                              \
+  name##_alloc_table(M, 2 * M->oldCapacity);                                    \
+}                                                                               \
+                                                                                \
+/* Pointer to key's value, or NULL. Valid until the next put */                 \
+static inline V* name##_get(struct name* M, K k) {                              \
+  REQUIRES(M != NULL);                                                          \
+  uint64_t h = hash_fn(k);                                                      \
+  size_t i = name##_find_in(M->ctrl, M->slots, M->capacity, k, h);              \
+  if (i != SIZE_MAX) return &M->slots[i].value;                                 \
+  if (M->oldCtrl == NULL) return NULL;                                          \
+  i = name##_find_in(M->oldCtrl, M->oldSlots, M->oldCapacity, k, h);            \
+  return (i != SIZE_MAX) ? &M->oldSlots[i].value : NULL;                        \
+}                                                                               \
+                                                                                \
+/* Inserts key k, or overwrites its value. Returns the stored value */          \
+static inline V* name##_put(struct name* M, K k, V value) {                     \
+  REQUIRES(M != NULL);                                                          \
+  uint64_t h = hash_fn(k);                                                      \
+  if (M->oldCtrl != NULL) name##_migrate(M, HMAP_MIGRATE_STEP);                 \
+  size_t i = name##_find_in(M->ctrl, M->slots, M->capacity, k, h);              \
+  if (i != SIZE_MAX) {                                                          \
+    M->slots[i].value = value;                                                  \
+    return &M->slots[i].value;                                                  \
+  }                                                                             \
+  if (M->oldCtrl != NULL) {                                                     \
+    i = name##_find_in(M->oldCtrl, M->oldSlots, M->oldCapacity, k, h);          \
+    if (i != SIZE_MAX) {                                                        \
+      M->oldCtrl[i] = HMAP_MOVED;  /* re-placed below with the new value */     \
+      M->size--;                                                                \
+    }                                                                           \
+  }                                                                             \
+  if (M->growthLeft == 0) name##_grow(M);                                       \
+  name##_place(M, k, value, h);                                                 \
+  M->size++;                                                                    \
+  return name##_get(M, k);                                                      \
+}                                                                               \
+                                                                                \
+static inline size_t name##_size(struct name* M) {                              \
+  REQUIRES(M != NULL);                                                          \
+  return M->size;                                                               \
+}                                                                               \
+                                                                                \
+static inline void name##_clear(struct name* M) {                               \
+  REQUIRES(M != NULL);                                                          \
+  name##_migrate(M, SIZE_MAX);                                                  \
+  memset(M->ctrl, HMAP_EMPTY, M->capacity);                                     \
+  M->size = 0;                                                                  \
+  M->growthLeft = M->capacity - M->capacity / 8;                                \
+}                                                                               \
+                                                                                \
+static inline void name##_free(struct name* M) {                                \
+  REQUIRES(M != NULL);                                                          \
+  free(M->ctrl);                                                                \
+  free(M->slots);                                                               \
+  free(M->oldCtrl);                                                             \
+  free(M->oldSlots);                                                            \
+  M->ctrl = M->oldCtrl = NULL;                                                  \
+  M->slots = M->oldSlots = NULL;                                                \
+}
+
+#endif
@@ -0,0 +1,72 @@
+/* Large allocations
+ * See large_alloc.h
+ */
+
+#define _DEFAULT_SOURCE  // MAP_ANONYMOUS, madvise
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/mman.h>
+#include "contracts.h"
+#include "large_alloc.h"
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+static size_t round_up(size_t size) {
+  return (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+}
+
+/* Maps size bytes (a multiple of HUGE_PAGE_SIZE) at a HUGE_PAGE_SIZE
+ * aligned address, by over-mapping and unmapping the slack on either side.
+ */
+static void* map_aligned(size_t size) {
+  size_t padded = size + HUGE_PAGE_SIZE;
+  char* p = mmap(NULL, padded, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) return NULL;
+  uintptr_t start = ((uintptr_t)p + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+  size_t head = start - (uintptr_t)p;
+  if (head > 0) munmap(p, head);
+  munmap((char*)start + size, padded - head - size);
+  return (void*)start;
+}
+
+void* large_alloc(size_t size, bool huge, enum pageKind* kind) {
+  REQUIRES(size > 0);
+  size = round_up(size);
+  void* p = NULL;
+  enum pageKind got = pagesNormal;
+
+#ifdef MAP_HUGETLB
+  if (huge) {
+    p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p == MAP_FAILED) p = NULL;
+    else got = pagesExplicit;
+  }
+#endif
+
+  if (p == NULL) {
+    p = map_aligned(size);
+    if (p == NULL) {
+      fprintf(stderr, "large_alloc of %zu bytes failed\n", size);
+      abort();
+    }
+#ifdef MADV_HUGEPAGE
+    if (huge && madvise(p, size, MADV_HUGEPAGE) == 0) got = pagesTransparent;
+#endif
+  }
+
+  if (kind != NULL) *kind = got;
+  ENSURES(p != NULL && (uintptr_t)p % HUGE_PAGE_SIZE == 0);
+  return p;
+}
+
+void large_free(void* p, size_t size) {
+  if (p == NULL) return;
+  munmap(p, round_up(size));
+}
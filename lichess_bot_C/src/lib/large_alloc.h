@@ -0,0 +1,32 @@
+/* Large allocations
+ * Page-aligned memory for big tables (ie. the transposition table),
+ * backed by 2 MB huge pages where the OS allows it, so that random
+ * probes do not miss in the TLB. Falls back to normal pages.
+ * Aborts when allocation fails, like xmalloc.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifndef _LARGE_ALLOC_H_
+#define _LARGE_ALLOC_H_
+
+#define HUGE_PAGE_SIZE ((size_t) 2 << 20)
+
+enum pageKind {
+    pagesNormal,       // Regular (4 KB) pages
+    pagesTransparent,  // Transparent huge pages requested with madvise (Linux)
+    pagesExplicit      // Reserved huge pages (Linux, /proc/sys/vm/nr_hugepages)
+};
+
+/* large_alloc(size, huge, &kind) returns a non-NULL, HUGE_PAGE_SIZE aligned
+ * pointer to size bytes, zeroed. With huge == false only normal pages are
+ * used. kind (if not NULL) is set to the pages actually requested.
+ */
+void* large_alloc(size_t size, bool huge, enum pageKind* kind);
+
+/* large_free(p, size) releases memory from large_alloc(size, ...).
+ */
+void large_free(void* p, size_t size);
+
+#endif
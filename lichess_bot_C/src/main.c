@@ -0,0 +1,244 @@
+//
+// Command line engine (`make playable`): a UCI loop around the search, printing its info lines.
+//
+
+#define _POSIX_C_SOURCE 200809L  // strtok_r, clock_gettime
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "dataStructs.h"
+#include "dev_tools.h"
+#include "movegen.h"
+#include "timeman.h"
+#include "book.h"
+#include "history.h"
+#include "multipv.h"
+#include "tt.h"
+#include "search_stats.h"
+#include "tbprobe.h"
+#include "search.h"
+#include "bench.h"
+
+#define ENGINE_NAME "ChessEngine"
+#define START_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+#define MAX_LINE 16384  // A "position ... moves" line for a long game
+
+static struct FEN_info position;
+static pthread_t search_thread;
+static bool searching = false;
+static int threads = 1;   // Threads option, which bench overrides while it runs
+static int multiPV = 1;   // MultiPV option, likewise
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Runs one search and prints its best move
+ */
+static void *_search_thread(void *arg) {
+    FEN root = arg;
+    struct search_result res;
+    search_position(root, &res);
+    printf("bestmove %s\n", res.move[0] ? res.move : "0000");
+    fflush(stdout);
+    free(root);
+    return NULL;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Waits for the running search, if any, to print its best move
+ */
+static void _join_search(void) {
+    if (!searching) return;
+    pthread_join(search_thread, NULL);
+    searching = false;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * "position [startpos | fen <fen>] [moves <move>...]". The position is left unchanged if anything is malformed.
+ * Positions the moves pass through become the game history, for repetition draws
+ */
+static void _uci_position(char *args) {
+    static uint64_t keys[MAX_GAME_PLY];
+    int numKeys = 0;
+    struct FEN_info res;
+    char *moves = strstr(args, "moves");
+    if (moves) *(moves - 1) = '\0';
+    if (strncmp(args, "startpos", 8) == 0) parse_fen(START_FEN, &res);
+    else if (strncmp(args, "fen ", 4) != 0 || parse_fen(args + 4, &res) == NULL) return;
+
+    if (moves) {
+        char *save;
+        for (char *uci = strtok_r(moves + 5, " \n", &save); uci; uci = strtok_r(NULL, " \n", &save)) {
+            struct move_info m;
+            if (!parse_uci_move(&res, uci, &m)) return;
+            if (numKeys < MAX_GAME_PLY) keys[numKeys++] = history_key(&res);
+            play_move(&res, &m);
+            if (res.halfMove == 0) numKeys = 0;  // Nothing before a capture or pawn move can repeat
+        }
+    }
+    position = res;
+    history_set_game(keys, numKeys);
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * "go [wtime <ms>] [btime <ms>] [winc <ms>] [binc <ms>] [movestogo <n>] [depth <n>] [nodes <n>] [movetime <ms>]
+ * [infinite] [ponder]". Searches on its own thread, so "stop" and "ponderhit" are read while it runs
+ */
+static void _uci_go(char *args) {
+    int64_t time[2] = {0, 0}, inc[2] = {0, 0}, movetime = 0;
+    int movesToGo = 0, depth = 0;
+    uint64_t nodes = 0;
+    bool infinite = false, ponder = false;
+    char *save;
+    for (char *token = strtok_r(args, " \n", &save); token; token = strtok_r(NULL, " \n", &save)) {
+        if (strcmp(token, "infinite") == 0) infinite = true;
+        else if (strcmp(token, "ponder") == 0) ponder = true;
+        else {
+            char *value = strtok_r(NULL, " \n", &save);
+            if (value == NULL) break;
+            long long n = strtoll(value, NULL, 10);
+            if (n < 0) n = 0;
+            if (strcmp(token, "wtime") == 0) time[0] = n;
+            else if (strcmp(token, "btime") == 0) time[1] = n;
+            else if (strcmp(token, "winc") == 0) inc[0] = n;
+            else if (strcmp(token, "binc") == 0) inc[1] = n;
+            else if (strcmp(token, "movestogo") == 0) movesToGo = (int) n;
+            else if (strcmp(token, "depth") == 0) depth = (n < MAX_PLY) ? (int) n : MAX_PLY - 1;
+            else if (strcmp(token, "nodes") == 0) nodes = (uint64_t) n;
+            else if (strcmp(token, "movetime") == 0) movetime = n;
+        }
+    }
+
+    int us = !position.whiteToMove;
+    search_set_depth(infinite ? MAX_PLY - 1 : depth);
+    search_set_nodes(nodes);
+    search_set_movetime(movetime);
+    tm_set_clock(time[us], inc[us], movesToGo);
+    tm_ponder(ponder || infinite);  // Both run until "stop" (or "ponderhit", which starts the clock)
+
+    FEN root = malloc(sizeof(struct FEN_info));
+    *root = position;
+    searching = pthread_create(&search_thread, NULL, _search_thread, root) == 0;
+    if (!searching) free(root);
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * "bench [depth]": searches the bench positions (see bench.h) to depth (default BENCH_DEPTH) with one thread and
+ * one line, from an empty transposition table, then prints the nodes, time and nodes per second. At the default
+ * depth and Hash the node count matches bench_API.py's. Clears the game history set by "position"
+ */
+static void _uci_bench(const char *args) {
+    int depth = atoi(args);
+    if (depth <= 0 || depth >= MAX_PLY) depth = BENCH_DEPTH;
+    search_set_threads(1);
+    multipv_set(1);
+    search_set_uci_output(false);
+    search_set_depth(depth);
+    search_set_nodes(0);
+    search_set_movetime(0);
+    tm_set_clock(0, 0, 0);
+    tm_ponder(false);
+    history_set_game(NULL, 0);
+    tt_clear();
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint64_t nodes = 0;
+    for (int i = 0; i < BENCH_POSITIONS; i++) {
+        struct search_result res;
+        lichess(bench_fens[i], "");
+        search_last_result(&res);
+        nodes += res.nodes;
+        printf("Position %d/%d: bestmove %s nodes %" PRIu64 "\n", i + 1, BENCH_POSITIONS,
+               res.move[0] ? res.move : "0000", res.nodes);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    int64_t ms = (int64_t) (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000;
+    printf("Total time (ms) : %" PRId64 "\n", ms);
+    printf("Nodes searched  : %" PRIu64 "\n", nodes);
+    printf("Nodes/second    : %" PRIu64 "\n", nodes * 1000 / (uint64_t) (ms > 0 ? ms : 1));
+
+    search_set_uci_output(true);
+    search_set_threads(threads);
+    multipv_set(multiPV);
+}
+
+
+int main(void) {
+    char line[MAX_LINE];
+    movegen_init();  // "position ... moves" needs the move generator before the first search
+    parse_fen(START_FEN, &position);
+    search_set_uci_output(true);
+
+    while (fgets(line, sizeof(line), stdin)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (strcmp(line, "uci") == 0) {
+            printf("id name " ENGINE_NAME "\n");
+            printf("option name Hash type spin default 16 min 1 max 65536\n");
+            printf("option name MultiPV type spin default 1 min 1 max %d\n", MAX_MULTIPV);
+            printf("option name Threads type spin default 1 min 1 max %d\n", MAX_SEARCH_THREADS);
+            printf("option name SyzygyPath type string default <empty>\n");
+            printf("uciok\n");
+        }
+        else if (strcmp(line, "isready") == 0) printf("readyok\n");
+        else if (strcmp(line, "ucinewgame") == 0) {
+            _join_search();
+            tt_clear();
+        }
+        else if (strncmp(line, "setoption name Hash value ", 26) == 0) {
+            _join_search();
+            tt_resize((size_t) strtoull(line + 26, NULL, 10));
+        }
+        else if (strncmp(line, "setoption name MultiPV value ", 29) == 0) {
+            multiPV = atoi(line + 29);
+            multipv_set(multiPV);
+        }
+        else if (strncmp(line, "setoption name Threads value ", 29) == 0) {
+            _join_search();
+            threads = atoi(line + 29);
+            search_set_threads(threads);
+        }
+        else if (strncmp(line, "setoption name SyzygyPath value ", 32) == 0) {
+            _join_search();
+            int found = tb_init(strcmp(line + 32, "<empty>") == 0 ? "" : line + 32);
+            printf("info string %d tablebase files, up to %d pieces\n", found, tb_largest());
+        }
+        else if (strncmp(line, "position ", 9) == 0) {
+            _join_search();
+            _uci_position(line + 9);
+        }
+        else if (strncmp(line, "go", 2) == 0) {
+            _join_search();
+            _uci_go(line + 2);
+        }
+        else if (strncmp(line, "bench", 5) == 0) {
+            _join_search();
+            _uci_bench(line + 5);
+        }
+        else if (strcmp(line, "ponderhit") == 0) tm_ponderhit();
+        else if (strcmp(line, "stop") == 0) {
+            tm_stop();
+            _join_search();
+        }
+        else if (strcmp(line, "quit") == 0) break;
+        fflush(stdout);
+    }
+    tm_stop();
+    _join_search();
+    return 0;
+}
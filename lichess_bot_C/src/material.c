@@ -0,0 +1,227 @@
+//
+// Material signatures: phase, imbalance and specialised endgame evaluators, looked up by piece counts.
+//
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "lib/contracts.h"
+#include "lib/xalloc.h"
+#include "dataStructs.h"
+#include "board_manipulations.h"
+#include "bitbase.h"
+#include "material.h"
+
+#define LIGHT_SQUARES 0x55AA55AA55AA55AAUL
+
+static const int piece_radix[whiteKing] = {9, 3, 3, 3, 2};  // Counts each key covers, per piece type
+static struct material_entry *material_table;
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Kaufman's imbalance terms for one side: the bishop pair, and knights / rooks gaining / losing value with pawns
+ */
+static int _side_imbalance(const int *count) {
+    int res = (count[whiteBishops] >= 2) ? 30 : 0;
+    res += count[whiteKnights] * (count[whitePawns] - 5) * 6;
+    res -= count[whiteRooks] * (count[whitePawns] - 5) * 12;
+    return res;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * @return Whether a side with these counts can force mate on a bare king without promoting
+ */
+static bool _mating_material(const int *count) {
+    return count[whiteQueens] || count[whiteRooks] || count[whiteBishops] >= 2
+           || (count[whiteBishops] && count[whiteKnights]);
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * @return Whether a side with these counts has at most one minor piece, or two knights, and nothing else
+ */
+static bool _no_mating_material(const int *count) {
+    int minors = count[whiteKnights] + count[whiteBishops];
+    if (count[whitePawns] || count[whiteRooks] || count[whiteQueens]) return false;
+    return minors <= 1 || (count[whiteKnights] == 2 && count[whiteBishops] == 0);
+}
+
+
+static int _non_pawns(const int *count) {
+    return count[whiteKnights] + count[whiteBishops] + count[whiteRooks] + count[whiteQueens];
+}
+
+
+static struct material_entry _classify(const int *white, const int *black) {
+    struct material_entry res = {0};
+    int phase = 0;
+    for (enum EPieceType p = whitePawns; p < whiteKing; p++) {
+        phase += gamePhaseInc[p] * (white[p] + black[p]);
+    }
+    res.phase = (phase > 24) ? 24 : phase;  // Early promotions can push the sum past the opening value
+    res.imbalance = _side_imbalance(white) - _side_imbalance(black);
+
+    bool whiteBare = !white[whitePawns] && !_non_pawns(white);
+    bool blackBare = !black[whitePawns] && !_non_pawns(black);
+    if (whiteBare == blackBare) {
+        if (_no_mating_material(white) && _no_mating_material(black)) {
+            res.evaluator = egDraw;
+        } else if (white[whiteBishops] == 1 && black[whiteBishops] == 1 && _non_pawns(white) == 1
+                   && _non_pawns(black) == 1) {
+            res.evaluator = egBishops;
+        }
+        return res;
+    }
+
+    res.strongWhite = blackBare;
+    const int *strong = blackBare ? white : black;
+    if (strong[whitePawns] == 1 && !_non_pawns(strong)) {
+        res.evaluator = egKPK;
+    } else if (!strong[whitePawns] && _non_pawns(strong) == 2 && strong[whiteBishops] == 1
+               && strong[whiteKnights] == 1) {
+        res.evaluator = egKBNK;
+    } else if (_mating_material(strong)) {
+        res.evaluator = egKXK;
+    } else if (_no_mating_material(strong)) {
+        res.evaluator = egDraw;
+    }
+    return res;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Decodes one side's half of a key back into piece counts
+ */
+static void _side_counts(uint32_t key, int *count) {
+    for (enum EPieceType p = whitePawns; p < whiteKing; p++) {
+        count[p] = (int) (key % piece_radix[p]);
+        key /= piece_radix[p];
+    }
+}
+
+
+void material_init(void) {
+    if (material_table != NULL) return;
+    struct material_entry *table = xcalloc(MATERIAL_KEYS, sizeof(struct material_entry));
+    int white[whiteKing], black[whiteKing];
+    for (uint32_t key = 0; key < MATERIAL_KEYS; key++) {
+        _side_counts(key % MATERIAL_SIDE_KEYS, white);
+        _side_counts(key / MATERIAL_SIDE_KEYS, black);
+        table[key] = _classify(white, black);
+    }
+    material_table = table;
+}
+
+
+uint32_t material_key(const uint64_t *BBoard) {
+    uint32_t res = 0;
+    for (int side = 1; side >= 0; side--) {
+        for (enum EPieceType p = whiteQueens + 1; p-- > whitePawns;) {
+            int count = popCount(BBoard[p + side * colorOffset]);
+            if (count >= piece_radix[p]) return MATERIAL_NO_KEY;
+            res = res * piece_radix[p] + count;
+        }
+    }
+    ENSURES(res < MATERIAL_KEYS);
+    return res;
+}
+
+
+const struct material_entry *material_probe(uint32_t key) {
+    REQUIRES(material_table != NULL);
+    if (key == MATERIAL_NO_KEY) return NULL;
+    return &material_table[key];
+}
+
+
+/**********************
+ * ENDGAME EVALUATORS
+ * Scored for the strong side
+**********************/
+static int _distance(enum enumSquare a, enum enumSquare b) {
+    int files = abs((int) (a & 7) - (int) (b & 7));
+    int ranks = abs((int) (a >> 3) - (int) (b >> 3));
+    return (files > ranks) ? files : ranks;
+}
+
+
+static int _edge_distance(enum enumSquare sq) {
+    int file = sq & 7, rank = sq >> 3;
+    int fileEdge = (file < 4) ? file : 7 - file;
+    int rankEdge = (rank < 4) ? rank : 7 - rank;
+    return (fileEdge < rankEdge) ? fileEdge : rankEdge;
+}
+
+
+static int _material(const uint64_t *BBoard, int side) {
+    int res = 0;
+    for (enum EPieceType p = whitePawns; p < whiteKing; p++) {
+        res += eg_value[p] * popCount(BBoard[p + side * colorOffset]);
+    }
+    return res;
+}
+
+
+static int _kxk(FEN position, bool strongWhite) {
+    int strong = strongWhite ? 0 : colorOffset;
+    int weak = strongWhite ? colorOffset : 0;
+    enum enumSquare strongKing = bitScanForward(position->BBoard[whiteKing + strong]);
+    enum enumSquare weakKing = bitScanForward(position->BBoard[whiteKing + weak]);
+    return KNOWN_WIN + _material(position->BBoard, !strongWhite)
+           + 20 * (3 - _edge_distance(weakKing)) + 10 * (7 - _distance(strongKing, weakKing));
+}
+
+
+static int _kbnk(FEN position, bool strongWhite) {
+    int strong = strongWhite ? 0 : colorOffset;
+    int weak = strongWhite ? colorOffset : 0;
+    enum enumSquare strongKing = bitScanForward(position->BBoard[whiteKing + strong]);
+    enum enumSquare weakKing = bitScanForward(position->BBoard[whiteKing + weak]);
+    bool lightBishop = (position->BBoard[whiteBishops + strong] & LIGHT_SQUARES) != 0;
+
+    // Mate is only forced in a corner the bishop can attack
+    int cornerA = lightBishop ? _distance(weakKing, h1) : _distance(weakKing, a1);
+    int cornerB = lightBishop ? _distance(weakKing, a8) : _distance(weakKing, h8);
+    int corner = (cornerA < cornerB) ? cornerA : cornerB;
+    return KNOWN_WIN + eg_value[whiteBishops] + eg_value[whiteKnights]
+           + 20 * (7 - corner) + 10 * (7 - _distance(strongKing, weakKing));
+}
+
+
+int material_evaluate(FEN position, const struct material_entry *entry, int eval) {
+    REQUIRES(position != NULL);
+    if (entry == NULL) return eval;
+    eval += position->whiteToMove ? entry->imbalance : -entry->imbalance;
+
+    bool strongToMove = (entry->strongWhite == position->whiteToMove);
+    int res;
+    switch (entry->evaluator) {
+        case egDraw:
+            return 0;
+        case egKXK:
+            res = _kxk(position, entry->strongWhite);
+            return strongToMove ? res : -res;
+        case egKBNK:
+            res = _kbnk(position, entry->strongWhite);
+            return strongToMove ? res : -res;
+        case egKPK: {
+            if (!bitbase_probe(position, &res)) return eval;
+            if (res == 0) return 0;
+            int pawnRank = bitScanForward(position->BBoard[entry->strongWhite ? whitePawns : blackPawns]) >> 3;
+            return res * (KNOWN_WIN + 10 * (entry->strongWhite ? pawnRank : 7 - pawnRank));
+        }
+        case egBishops: {
+            bool whiteLight = (position->BBoard[whiteBishops] & LIGHT_SQUARES) != 0;
+            bool blackLight = (position->BBoard[blackBishops] & LIGHT_SQUARES) != 0;
+            return (whiteLight != blackLight) ? eval / 2 : eval;
+        }
+        default:
+            return eval;
+    }
+}
@@ -0,0 +1,67 @@
+//
+// Material signatures: phase, imbalance and specialised endgame evaluators, looked up by piece counts.
+//
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef CHESS_MATERIAL_H
+#define CHESS_MATERIAL_H
+
+/**
+ * Key layout: per side, pawns [0, 8], knights / bishops / rooks [0, 2] and queens [0, 1], mixed-radix.
+ * Anything outside those ranges (ie. after an under-promotion) has no key and uses the general evaluation
+ */
+#define MATERIAL_SIDE_KEYS (9 * 3 * 3 * 3 * 2)
+#define MATERIAL_KEYS (MATERIAL_SIDE_KEYS * MATERIAL_SIDE_KEYS)
+#define MATERIAL_NO_KEY UINT32_MAX
+
+#define KNOWN_WIN 5000  // Above any PeSTO evaluation, below mate scores
+
+enum endgameEvaluator {
+    egNone,     // General evaluation
+    egDraw,     // Neither side can force mate (ie. KNK, KBKN, KNNK)
+    egKXK,      // Mating material against a bare king: drive the king to the edge
+    egKBNK,     // As egKXK, but to a corner of the bishop's colour
+    egKPK,      // Exact result from the KPvK bitbase, when loaded
+    egBishops   // One bishop each plus pawns: halved if the bishops are on opposite colours
+};
+
+/**
+ * Everything about a position that depends only on its piece counts
+ */
+struct material_entry {
+    int16_t imbalance;  // Correction to the piece values, from white's perspective
+    uint8_t phase;      // PeSTO game phase [0, 24], 24 being the opening
+    uint8_t evaluator;  // enum endgameEvaluator
+    bool strongWhite;   // Side the evaluator plays for
+};
+
+/**
+ * Fills the table. Call once at startup, before material_probe
+ */
+void material_init(void);
+
+/**
+ * @param BBoard
+ * @return Material key of the position, or MATERIAL_NO_KEY if a piece count is out of range
+ */
+uint32_t material_key(const uint64_t *BBoard);
+
+/**
+ * A single table read
+ * @param key From material_key
+ * @return Entry for key, or NULL for MATERIAL_NO_KEY
+ */
+const struct material_entry *material_probe(uint32_t key);
+
+/**
+ * Applies the entry's imbalance and, if it has one, its endgame evaluator
+ * @param position
+ * @param entry From material_probe, or NULL
+ * @param eval General (PeSTO) evaluation from the side to move's perspective
+ * @return Final evaluation from the side to move's perspective
+ */
+int material_evaluate(FEN position, const struct material_entry *entry, int eval);
+
+#endif //CHESS_MATERIAL_H
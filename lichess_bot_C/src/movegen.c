@@ -0,0 +1,443 @@
+//
+// Move generation: attack sets, pseudo-legal and legal moves, and playing a move on a whole position.
+//
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "lib/contracts.h"
+#include "dataStructs.h"
+#include "board_manipulations.h"
+#include "dev_tools.h"
+#include "variant.h"
+#include "crazyhouse.h"
+#include "movegen.h"
+
+#define RANK_1 0x00000000000000FFUL
+#define RANK_3 0x0000000000FF0000UL
+#define RANK_6 0x0000FF0000000000UL
+#define RANK_8 0xFF00000000000000UL
+
+enum rayDirection {north, east, northEast, northWest, south, west, southEast, southWest, numDirections};
+
+static uint64_t knight_table[64];
+static uint64_t king_table[64];
+static uint64_t pawn_table[2][64];  // [white][sq]
+static uint64_t ray_table[numDirections][64];
+static bool initialized = false;
+
+
+/**********************
+ * ATTACKS
+**********************/
+void movegen_init(void) {
+    if (initialized) return;
+    crazyhouse_init();
+    uint64_t (*rays[numDirections])(enum enumSquare) = {
+        northRay, eastRay, northEastRay, northWestRay, southRay, westRay, southEastRay, southWestRay
+    };
+    for (enum enumSquare sq = a1; sq < totalSquares; sq++) {
+        uint64_t bb = 1UL << sq;
+        knight_table[sq] = ((bb << 17) & not_a_file) | ((bb << 15) & not_h_file) | ((bb << 10) & not_ab_file)
+                           | ((bb << 6) & not_hg_file) | ((bb >> 15) & not_a_file) | ((bb >> 17) & not_h_file)
+                           | ((bb >> 6) & not_ab_file) | ((bb >> 10) & not_hg_file);
+        uint64_t sides = ((bb << 1) & not_a_file) | ((bb >> 1) & not_h_file);
+        king_table[sq] = sides | ((bb | sides) << 8) | ((bb | sides) >> 8);
+        pawn_table[true][sq] = ((bb << 9) & not_a_file) | ((bb << 7) & not_h_file);
+        pawn_table[false][sq] = ((bb >> 7) & not_a_file) | ((bb >> 9) & not_h_file);
+        for (enum rayDirection dir = north; dir < numDirections; dir++) ray_table[dir][sq] = rays[dir](sq);
+    }
+    initialized = true;
+}
+
+
+uint64_t knight_attacks(enum enumSquare sq) {return knight_table[sq];}
+
+uint64_t king_attacks(enum enumSquare sq) {return king_table[sq];}
+
+uint64_t pawn_attacks(enum enumSquare sq, bool white) {return pawn_table[white][sq];}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Ray attacks stop at the first blocker. Rays towards h8 find it with a forward scan, the others with a reverse scan
+ */
+static uint64_t _ray_attacks(enum rayDirection dir, enum enumSquare sq, uint64_t occ) {
+    uint64_t attacks = ray_table[dir][sq];
+    uint64_t blockers = attacks & occ;
+    if (blockers) {
+        enum enumSquare first = (dir < south) ? bitScanForward(blockers) : bitScanReverse(blockers);
+        attacks ^= ray_table[dir][first];
+    }
+    return attacks;
+}
+
+
+uint64_t bishop_attacks(enum enumSquare sq, uint64_t occ) {
+    return _ray_attacks(northEast, sq, occ) | _ray_attacks(northWest, sq, occ)
+           | _ray_attacks(southEast, sq, occ) | _ray_attacks(southWest, sq, occ);
+}
+
+
+uint64_t rook_attacks(enum enumSquare sq, uint64_t occ) {
+    return _ray_attacks(north, sq, occ) | _ray_attacks(east, sq, occ)
+           | _ray_attacks(south, sq, occ) | _ray_attacks(west, sq, occ);
+}
+
+
+bool square_attacked(const uint64_t *BBoard, enum enumSquare sq, bool byWhite) {
+    REQUIRES(initialized);
+    int them = byWhite ? 0 : colorOffset;
+    uint64_t occ = BBoard[whiteAll] | BBoard[blackAll];
+    if (pawn_table[!byWhite][sq] & BBoard[whitePawns + them]) return true;  // Pawns attacking sq stand where it would
+    if (knight_table[sq] & BBoard[whiteKnights + them]) return true;
+    if (king_table[sq] & BBoard[whiteKing + them]) return true;
+    uint64_t diagonal = BBoard[whiteBishops + them] | BBoard[whiteQueens + them];
+    if (diagonal && (bishop_attacks(sq, occ) & diagonal)) return true;
+    uint64_t straight = BBoard[whiteRooks + them] | BBoard[whiteQueens + them];
+    return straight && (rook_attacks(sq, occ) & straight);
+}
+
+
+bool in_check(FEN position) {
+    REQUIRES(position != NULL);
+    uint64_t king = position->BBoard[position->whiteToMove ? whiteKing : blackKing];
+    return king && square_attacked(position->BBoard, bitScanForward(king), !position->whiteToMove);
+}
+
+
+bool mover_in_check(FEN position) {
+    REQUIRES(position != NULL);
+    uint64_t king = position->BBoard[position->whiteToMove ? blackKing : whiteKing];
+    return king && square_attacked(position->BBoard, bitScanForward(king), position->whiteToMove);
+}
+
+
+/**********************
+ * GENERATION
+**********************/
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Appends a pawn move, or all four promotions if it reaches the last rank
+ * @param queensOnly Only the queen promotion (ie. for the quiescence search)
+ * @return New number of moves
+ */
+static int _add_pawn_move(struct move_info *res, int n, enum enumSquare from, enum enumSquare to,
+                          enum EPieceType piece, bool queensOnly) {
+    if ((1UL << to) & (RANK_1 | RANK_8)) {
+        for (enum EPieceType promotion = whiteQueens; promotion >= whiteKnights; promotion--) {
+            res[n++] = (struct move_info) {from, to, piece, promotion};
+            if (queensOnly) break;
+        }
+        return n;
+    }
+    res[n++] = (struct move_info) {from, to, piece, 0};
+    return n;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Pawn pushes (quiet: every push, else only pushes that promote) and captures (including en passant)
+ * @return New number of moves
+ */
+static int _pawn_moves(FEN position, struct move_info *res, int n, bool quiet) {
+    bool white = position->whiteToMove;
+    enum EPieceType piece = white ? whitePawns : blackPawns;
+    uint64_t pawns = position->BBoard[piece];
+    uint64_t occ = position->BBoard[whiteAll] | position->BBoard[blackAll];
+    uint64_t enemy = position->BBoard[white ? blackAll : whiteAll];
+
+    uint64_t single = (white ? pawns << 8 : pawns >> 8) & ~occ;
+    uint64_t pushes = quiet ? single : single & (RANK_1 | RANK_8);
+    while (pushes) {
+        enum enumSquare to = bitScanForward(pushes);
+        pushes &= pushes - 1;
+        n = _add_pawn_move(res, n, white ? to - 8 : to + 8, to, piece, !quiet);
+    }
+    if (quiet) {
+        uint64_t doubles = (white ? (single & RANK_3) << 8 : (single & RANK_6) >> 8) & ~occ;
+        while (doubles) {
+            enum enumSquare to = bitScanForward(doubles);
+            doubles &= doubles - 1;
+            res[n++] = (struct move_info) {white ? to - 16 : to + 16, to, piece, 0};
+        }
+    }
+
+    while (pawns) {
+        enum enumSquare from = bitScanForward(pawns);
+        pawns &= pawns - 1;
+        uint64_t targets = pawn_table[white][from] & (enemy | position->enPassant);
+        while (targets) {
+            enum enumSquare to = bitScanForward(targets);
+            targets &= targets - 1;
+            n = _add_pawn_move(res, n, from, to, piece, !quiet);
+        }
+    }
+    return n;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Knight, bishop, rook, queen and king moves onto squares in targets
+ * @return New number of moves
+ */
+static int _piece_moves(FEN position, struct move_info *res, int n, uint64_t targets) {
+    int us = position->whiteToMove ? 0 : colorOffset;
+    uint64_t occ = position->BBoard[whiteAll] | position->BBoard[blackAll];
+    for (enum EPieceType type = whiteKnights; type <= whiteKing; type++) {
+        uint64_t pieces = position->BBoard[type + us];
+        while (pieces) {
+            enum enumSquare from = bitScanForward(pieces);
+            pieces &= pieces - 1;
+            uint64_t attacks;
+            switch (type) {
+                case whiteKnights: attacks = knight_table[from]; break;
+                case whiteBishops: attacks = bishop_attacks(from, occ); break;
+                case whiteRooks: attacks = rook_attacks(from, occ); break;
+                case whiteQueens: attacks = bishop_attacks(from, occ) | rook_attacks(from, occ); break;
+                default: attacks = king_table[from]; break;
+            }
+            attacks &= targets;
+            while (attacks) {
+                res[n++] = (struct move_info) {from, bitScanForward(attacks), type + us, 0};
+                attacks &= attacks - 1;
+            }
+        }
+    }
+    return n;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Castling, fully checked: squares between king / rook and their destinations empty, and the king not passing
+ * through check. Rights for a rook that is not there (ie. a hand-written FEN) are ignored
+ * @return New number of moves
+ */
+static int _castling_moves(FEN position, struct move_info *res, int n) {
+    bool white = position->whiteToMove;
+    uint64_t rights = position->castling & (white ? RANK_1 : RANK_8);
+    uint64_t king = position->BBoard[white ? whiteKing : blackKing] & (white ? RANK_1 : RANK_8);
+    if (!rights || !king) return n;
+    uint64_t occ = position->BBoard[whiteAll] | position->BBoard[blackAll];
+    while (rights) {
+        enum enumSquare kingDest = bitScanForward(rights);
+        rights &= rights - 1;
+        enum enumSquare rook = castling_rook(position, kingDest);
+        if (!(position->BBoard[white ? whiteRooks : blackRooks] >> rook & 1)) continue;
+        if (occ & castling_empty_squares(position, kingDest)) continue;
+
+        uint64_t path = castling_king_path(position, kingDest);
+        bool attacked = false;
+        while (path && !attacked) {
+            attacked = square_attacked(position->BBoard, bitScanForward(path), !white);
+            path &= path - 1;
+        }
+        if (!attacked) res[n++] = (struct move_info) {bitScanForward(king), rook, white ? whiteKing : blackKing, 0};
+    }
+    return n;
+}
+
+
+int generate_pseudo_moves(FEN position, struct move_info *res) {
+    REQUIRES(position != NULL && res != NULL && initialized);
+    int n = _pawn_moves(position, res, 0, true);
+    n = _piece_moves(position, res, n, ~position->BBoard[position->whiteToMove ? whiteAll : blackAll]);
+    n = _castling_moves(position, res, n);
+    if (variant_crazyhouse(position)) n += generate_drops(position, res + n);
+    ENSURES(n <= MAX_MOVES);
+    return n;
+}
+
+
+int generate_captures(FEN position, struct move_info *res) {
+    REQUIRES(position != NULL && res != NULL && initialized);
+    int n = _pawn_moves(position, res, 0, false);
+    n = _piece_moves(position, res, n, position->BBoard[position->whiteToMove ? blackAll : whiteAll]);
+    ENSURES(n <= MAX_MOVES);
+    return n;
+}
+
+
+int generate_moves(FEN position, struct move_info *res) {
+    REQUIRES(position != NULL && res != NULL);
+    int n = generate_pseudo_moves(position, res);
+    int legal = 0;
+    for (int i = 0; i < n; i++) {
+        struct FEN_info after = *position;
+        play_move(&after, &res[i]);
+        if (!mover_in_check(&after)) res[legal++] = res[i];
+    }
+    return legal;
+}
+
+
+uint64_t perft(FEN position, int depth) {
+    REQUIRES(position != NULL && depth >= 0);
+    if (depth == 0) return 1;
+    struct move_info moves[MAX_MOVES];
+    int n = generate_moves(position, moves);
+    if (depth == 1) return n;
+    uint64_t res = 0;
+    for (int i = 0; i < n; i++) {
+        struct FEN_info after = *position;
+        play_move(&after, &moves[i]);
+        res += perft(&after, depth - 1);
+    }
+    return res;
+}
+
+
+/**********************
+ * MAKING MOVES
+**********************/
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * @return Whether m is a castling move (the king taking its own rook)
+ */
+static bool _is_castle(FEN position, move m) {
+    bool white = m->piece < colorOffset;
+    uint64_t rooks = position->BBoard[white ? whiteRooks : blackRooks];
+    return m->piece == (white ? whiteKing : blackKing) && (rooks >> m->to & 1);
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Drops the castling rights that m takes away: all of a side's when its king moves, one when its rook moves or
+ * is captured. Called before m is played, while castling_rook can still find the rooks
+ */
+static void _update_castling(FEN position, move m) {
+    uint64_t touched = (1UL << m->from) | (1UL << m->to);
+    uint64_t rights = position->castling;
+    while (rights) {
+        enum enumSquare kingDest = bitScanForward(rights);
+        rights &= rights - 1;
+        bool white = kingDest < a2;
+        bool kingMoved = m->piece == (white ? whiteKing : blackKing);
+        enum enumSquare rook = castling_rook(position, kingDest);
+        if (kingMoved || (touched >> rook & 1)) {
+            position->castling &= ~(1UL << kingDest);
+#if VARIANT == VARIANT_CHESS960
+            position->castlingRooks &= ~(1UL << rook);
+#endif
+        }
+    }
+}
+
+
+enum EPieceType captured_piece(FEN position, move m) {
+    REQUIRES(position != NULL && m != NULL);
+    if (variant_crazyhouse(position) && m->from == DROP_FROM) return numPieceTypes;
+    enum EPieceType them = position->whiteToMove ? colorOffset : 0;
+    uint64_t to_bit = 1UL << m->to;
+    if (!(position->BBoard[whiteAll + them] & to_bit)) {
+        bool enPassant = (m->piece % colorOffset == whitePawns) && (to_bit & position->enPassant);
+        return enPassant ? whitePawns + them : numPieceTypes;
+    }
+    for (enum EPieceType piece = whitePawns + them; piece < whiteKing + them; piece++) {
+        if (position->BBoard[piece] & to_bit) return piece;
+    }
+    return numPieceTypes;  // Only a king is left, which is never captured in a legal game
+}
+
+
+void play_move(FEN position, move m) {
+    REQUIRES(position != NULL && m != NULL);
+    bool white = position->whiteToMove;
+    uint64_t *BBoard = position->BBoard;
+    uint64_t to_bit = 1UL << m->to;
+    // Crazyhouse drop. Neither a capture nor a pawn move for the 50-move rule
+    bool drop = variant_crazyhouse(position) && m->from == DROP_FROM;
+    bool pawnMove = !drop && m->piece % colorOffset == whitePawns;
+    bool capture = (BBoard[white ? blackAll : whiteAll] & to_bit) != 0;
+    uint64_t enPassant = position->enPassant;
+    position->enPassant = 0;
+
+    if (drop) make_drop(position, m);
+    else if (_is_castle(position, m)) {
+        enum enumSquare kingDest = (white ? a1 : a8) + ((m->to > m->from) ? 6 : 2);  // g or c file
+        make_castle(position, kingDest);
+    }
+    else {
+        if (position->castling) _update_castling(position, m);
+        if (pawnMove && (to_bit & enPassant)) {  // En passant: the captured pawn is behind the target square
+            uint64_t victim = white ? to_bit >> 8 : to_bit << 8;
+            BBoard[white ? blackPawns : whitePawns] &= ~victim;
+            BBoard[white ? blackAll : whiteAll] &= ~victim;
+            capture = true;
+            if (variant_crazyhouse(position)) crazyhouse_pocket(position, white ? blackPawns : whitePawns, false);
+        }
+        if (variant_crazyhouse(position)) crazyhouse_make_move(position, m);
+        else make_move(BBoard, m);
+        if (pawnMove && (m->to == m->from + 16 || m->from == m->to + 16)) {
+            position->enPassant = 1UL << ((m->from + m->to) / 2);
+        }
+    }
+
+#if VARIANT == VARIANT_THREECHECK
+    uint64_t theirKing = BBoard[white ? blackKing : whiteKing];
+    variant_after_move(position, theirKing && square_attacked(BBoard, bitScanForward(theirKing), white));
+#endif
+    position->halfMove = (pawnMove || capture) ? 0 : position->halfMove + 1;
+    if (!white) position->fullMove++;
+    position->whiteToMove = !white;
+}
+
+
+void play_null_move(FEN position) {
+    REQUIRES(position != NULL);
+    position->enPassant = 0;
+    position->halfMove++;
+    if (!position->whiteToMove) position->fullMove++;
+    position->whiteToMove = !position->whiteToMove;
+}
+
+
+/**********************
+ * NOTATION
+**********************/
+int move_to_uci(move m, char *res) {
+    REQUIRES(m != NULL && res != NULL);
+    if (m->from == DROP_FROM) {  // Crazyhouse drop, ie. "N@f3"
+        res[0] = "PNBRQK"[m->piece % colorOffset];
+        res[1] = '@';
+        enumSquare_to_string(res + 2, m->to);
+        res[4] = '\0';
+        return 4;
+    }
+    enum enumSquare to = m->to;
+#if VARIANT != VARIANT_CHESS960
+    // Standard chess names castling by the king's destination
+    if (m->piece % colorOffset == whiteKing && (m->to % 8 > m->from % 8 + 1 || m->from % 8 > m->to % 8 + 1)) {
+        to = (m->to > m->from) ? m->from + 2 : m->from - 2;
+    }
+#endif
+    enumSquare_to_string(res, m->from);
+    enumSquare_to_string(res + 2, to);
+    int n = 4;
+    bool pawn = m->piece % colorOffset == whitePawns;
+    if (pawn && ((1UL << m->to) & (RANK_1 | RANK_8))) res[n++] = "pnbrqk"[m->promotion ? m->promotion : whiteQueens];
+    res[n] = '\0';
+    return n;
+}
+
+
+bool parse_uci_move(FEN position, const char *uci, move res) {
+    REQUIRES(position != NULL && uci != NULL && res != NULL);
+    size_t length = strcspn(uci, " ");
+    if (length < 4 || length > 5) return false;
+    struct move_info moves[MAX_MOVES];
+    int n = generate_moves(position, moves);
+    for (int i = 0; i < n; i++) {
+        char name[6];
+        if ((size_t) move_to_uci(&moves[i], name) == length && strncmp(name, uci, length) == 0) {
+            *res = moves[i];
+            return true;
+        }
+    }
+    return false;
+}
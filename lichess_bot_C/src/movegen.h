@@ -0,0 +1,140 @@
+//
+// Move generation: attack sets, pseudo-legal and legal moves, and playing a move on a whole position.
+//
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef CHESS_MOVEGEN_H
+#define CHESS_MOVEGEN_H
+
+/**
+ * More moves than any position has: 218 is the most known in chess, and crazyhouse adds up to MAX_DROPS drops
+ */
+#define MAX_MOVES 576
+
+/**
+ * Castling is stored as the king capturing its own rook (from = king, to = rook), which also covers Chess960.
+ * move_to_uci writes it back as the king's two-square move (ie. e1g1) in standard chess
+ */
+
+
+/**********************
+ * ATTACKS
+**********************/
+/**
+ * Fills the knight, king and pawn attack tables and the slider rays. Call once before anything below
+ */
+void movegen_init(void);
+
+uint64_t knight_attacks(enum enumSquare sq);
+uint64_t king_attacks(enum enumSquare sq);
+uint64_t pawn_attacks(enum enumSquare sq, bool white);  // Squares a pawn of that colour on sq attacks
+uint64_t bishop_attacks(enum enumSquare sq, uint64_t occ);
+uint64_t rook_attacks(enum enumSquare sq, uint64_t occ);
+
+/**
+ * @param BBoard
+ * @param sq
+ * @param byWhite Attacking colour
+ * @return Whether any piece of that colour attacks sq
+ */
+bool square_attacked(const uint64_t *BBoard, enum enumSquare sq, bool byWhite);
+
+/**
+ * @param position
+ * @return Whether the side to move is in check
+ */
+bool in_check(FEN position);
+
+/**
+ * @param position After play_move
+ * @return Whether the move just played left its own king in check (ie. it was not legal)
+ */
+bool mover_in_check(FEN position);
+
+
+/**********************
+ * GENERATION
+**********************/
+/**
+ * Generates every pseudo-legal move: the king may be left in check, except that castling is fully checked.
+ * In the Crazyhouse build, positions with pockets (position->crazyhouse) get their drops too
+ * @param position
+ * @param res Buffer of at least MAX_MOVES moves
+ * @return Number of moves written to res
+ */
+int generate_pseudo_moves(FEN position, struct move_info *res);
+
+/**
+ * Pseudo-legal captures (en passant included) and queen promotions, for the quiescence search
+ * @param position
+ * @param res Buffer of at least MAX_MOVES moves
+ * @return Number of moves written to res
+ */
+int generate_captures(FEN position, struct move_info *res);
+
+/**
+ * Legal moves only
+ * @param position
+ * @param res Buffer of at least MAX_MOVES moves
+ * @return Number of moves written to res
+ */
+int generate_moves(FEN position, struct move_info *res);
+
+/**
+ * Counts leaf nodes of the legal move tree, for checking the generator against known counts
+ * @param position Not modified
+ * @param depth
+ * @return Number of move sequences of length depth
+ */
+uint64_t perft(FEN position, int depth);
+
+
+/**********************
+ * MAKING MOVES
+**********************/
+/**
+ * Plays m on the whole position: captures, castling, en passant and promotions, castling rights,
+ * en passant square, clocks and side to move, and in crazyhouse drops, pockets and promoted pieces.
+ * m must come from one of the generators above
+ * @param position
+ * @param m
+ */
+void play_move(FEN position, move m);
+
+/**
+ * Passes the turn, for null-move pruning
+ * @param position
+ */
+void play_null_move(FEN position);
+
+/**
+ * @param position Before m is played
+ * @param m
+ * @return Piece type captured by m (en passant included), or numPieceTypes if m captures nothing
+ */
+enum EPieceType captured_piece(FEN position, move m);
+
+
+/**********************
+ * NOTATION
+**********************/
+/**
+ * Writes m in UCI notation (ie. "e2e4", "e7e8n", "e1g1", or "N@f3" for a crazyhouse drop)
+ * @param m
+ * @param res Buffer of at least 6 chars. Will be NUL-terminated
+ * @return Number of characters written, excluding the NUL
+ */
+int move_to_uci(move m, char *res);
+
+/**
+ * Finds the legal move that uci names
+ * @param position
+ * @param uci Move in UCI notation. Read up to the first space or NUL
+ * @param res Set to the move, if it is legal
+ * @return Whether uci is a legal move in position
+ */
+bool parse_uci_move(FEN position, const char *uci, move res);
+
+#endif //CHESS_MOVEGEN_H
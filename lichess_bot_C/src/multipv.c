@@ -0,0 +1,116 @@
+//
+// Multi-PV: the best N root moves, each with its own score and principal variation.
+//
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "lib/contracts.h"
+#include "dataStructs.h"
+#include "movegen.h"
+#include "search.h"
+#include "multipv.h"
+
+static int multipv_lines = 1;
+static struct multipv last_search;
+
+
+void multipv_set(int n) {
+    if (n < 1) n = 1;
+    if (n > MAX_MULTIPV) n = MAX_MULTIPV;
+    multipv_lines = n;
+}
+
+
+void multipv_start(multipv mpv) {
+    REQUIRES(mpv != NULL);
+    mpv->numLines = multipv_lines;
+    mpv->found = 0;
+}
+
+
+static bool _same_move(const struct move_info *a, const struct move_info *b) {
+    return a->from == b->from && a->to == b->to && a->piece == b->piece && a->promotion == b->promotion;
+}
+
+
+bool multipv_excluded(multipv mpv, int line, move m) {
+    REQUIRES(mpv != NULL && m != NULL);
+    for (int i = 0; i < line && i < mpv->found; i++) {
+        if (_same_move(&mpv->lines[i].moves[0], m)) return true;
+    }
+    return false;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * @return Whether line a sorts before line b
+ */
+static bool _better(const struct pv_line *a, const struct pv_line *b) {
+    if (a->score != b->score) return a->score > b->score;
+    return a->depth > b->depth;
+}
+
+
+void multipv_store(multipv mpv, const struct pv_line *line) {
+    REQUIRES(mpv != NULL && line != NULL && line->length > 0 && line->length <= MAX_PV_LENGTH);
+    int i = 0;
+    while (i < mpv->found && !_same_move(&mpv->lines[i].moves[0], &line->moves[0])) i++;
+    if (i == mpv->found) {
+        if (mpv->found == mpv->numLines) {
+            if (!_better(line, &mpv->lines[mpv->found - 1])) return;  // Worse than every line kept
+            i = mpv->found - 1;
+        } else {
+            mpv->found++;
+        }
+    }
+
+    // Insertion sort: at most one line is out of place
+    mpv->lines[i] = *line;
+    for (; i > 0 && _better(&mpv->lines[i], &mpv->lines[i - 1]); i--) {
+        struct pv_line tmp = mpv->lines[i];
+        mpv->lines[i] = mpv->lines[i - 1];
+        mpv->lines[i - 1] = tmp;
+    }
+    for (; i + 1 < mpv->found && _better(&mpv->lines[i + 1], &mpv->lines[i]); i++) {
+        struct pv_line tmp = mpv->lines[i];
+        mpv->lines[i] = mpv->lines[i + 1];
+        mpv->lines[i + 1] = tmp;
+    }
+}
+
+
+int multipv_info_string(multipv mpv, int index, char *res, size_t size) {
+    REQUIRES(mpv != NULL && 0 <= index && index < mpv->found && res != NULL);
+    const struct pv_line *line = &mpv->lines[index];
+    int mateScore = (line->score < 0) ? -line->score : line->score;
+    int n;
+    if (mateScore >= MATE_IN_MAX_PLY) {
+        int moves = (MATE_SCORE - mateScore + 1) / 2;
+        n = snprintf(res, size, "info multipv %d depth %d score mate %d pv", index + 1, line->depth,
+                     (line->score > 0) ? moves : -moves);
+    }
+    else n = snprintf(res, size, "info multipv %d depth %d score cp %d pv", index + 1, line->depth, line->score);
+    for (int i = 0; i < line->length && n >= 0 && (size_t) n < size; i++) {
+        char uci[8];
+        move_to_uci((move) &line->moves[i], uci);
+        n += snprintf(res + n, size - n, " %s", uci);
+    }
+    return n;
+}
+
+
+void multipv_publish(multipv mpv) {
+    REQUIRES(mpv != NULL);
+    last_search = *mpv;
+}
+
+
+int multipv_last_info(int index, char *res, size_t size) {
+    REQUIRES(res != NULL);
+    if (index < 0 || index >= last_search.found) return 0;
+    return multipv_info_string(&last_search, index, res, size);
+}
@@ -0,0 +1,91 @@
+//
+// Multi-PV: the best N root moves, each with its own score and principal variation.
+//
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef CHESS_MULTIPV_H
+#define CHESS_MULTIPV_H
+
+#define MAX_MULTIPV 16
+#define MAX_PV_LENGTH 64
+
+/**
+ * One principal variation. moves[0] is the root move the line is for
+ */
+struct pv_line {
+    int score;   // Centipawns, from the root side to move's perspective
+    int depth;   // Depth of the iteration that produced the line
+    int length;
+    struct move_info moves[MAX_PV_LENGTH];
+};
+
+/**
+ * Lines of one search, sorted best first once complete.
+ * At each depth the search runs the root once per line; run i skips the root moves of lines [0, i),
+ * so every line gets a different move. All runs share the transposition table, so later runs are mostly
+ * TT hits, and cost grows far slower than N full searches
+ */
+struct multipv {
+    int numLines;  // Lines requested, [1, MAX_MULTIPV]
+    int found;     // Lines filled so far (fewer than numLines if there are fewer legal moves)
+    struct pv_line lines[MAX_MULTIPV];
+};
+typedef struct multipv *multipv;
+
+/**
+ * Sets the number of lines searches report (UCI MultiPV option). Exported for the Python (ctypes) side
+ * @param n Clamped to [1, MAX_MULTIPV]
+ */
+void multipv_set(int n);
+
+/**
+ * @param mpv Reset for a new search, with the count from multipv_set
+ */
+void multipv_start(multipv mpv);
+
+/**
+ * @param mpv
+ * @param line Index of the root run about to start
+ * @param m A root move
+ * @return Whether run `line` must skip m, because an earlier line already has it
+ */
+bool multipv_excluded(multipv mpv, int line, move m);
+
+/**
+ * Stores the result of a root run, replacing any line for the same root move, and keeps lines sorted
+ * (higher score first, deeper first among equals)
+ * @param mpv
+ * @param line Result. Copied
+ */
+void multipv_store(multipv mpv, const struct pv_line *line);
+
+/**
+ * Formats a line as a UCI info line, ie. "info multipv 2 depth 9 score cp 31 pv e2e4 e7e5 g1f3" (moves as by
+ * move_to_uci, so under-promotions and drops are written as played)
+ * @param mpv
+ * @param index [0, mpv->found)
+ * @param res Buffer
+ * @param size Size of res
+ * @return Number of characters written (as snprintf)
+ */
+int multipv_info_string(multipv mpv, int index, char *res, size_t size);
+
+/**
+ * Publishes a finished search's lines for multipv_last_info. Copied, so the search may reuse mpv
+ * @param mpv
+ */
+void multipv_publish(multipv mpv);
+
+/**
+ * Exported for the Python (ctypes) side, after lichess() returns
+ * @param index Line, best first
+ * @param res Buffer
+ * @param size Size of res
+ * @return Characters written as by multipv_info_string, or 0 if the last search has no such line
+ */
+int multipv_last_info(int index, char *res, size_t size);
+
+#endif //CHESS_MULTIPV_H
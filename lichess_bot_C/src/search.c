@@ -0,0 +1,791 @@
+//
+// Search: iterative deepening over a principal variation alpha-beta search, and the lichess() entry point.
+//
+
+#define _POSIX_C_SOURCE 200809L  // nanosleep
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <omp.h>
+
+#include "lib/contracts.h"
+#include "lib/arena.h"
+#include "dataStructs.h"
+#include "board_manipulations.h"
+#include "dev_tools.h"
+#include "variant.h"
+#include "movegen.h"
+#include "crazyhouse.h"
+#include "evaluation.h"
+#include "timeman.h"
+#include "tt.h"
+#include "book.h"
+#include "history.h"
+#include "multipv.h"
+#include "affinity.h"
+#include "search_arena.h"
+#include "search_stats.h"
+#include "tbprobe.h"
+#include "material.h"
+#include "bitbase.h"
+#include "search.h"
+
+#define INFINITE_SCORE (MATE_SCORE + 1)
+#define TB_WIN_SCORE (MATE_IN_MAX_PLY - MAX_PLY)  // Tablebase win at the root: above any evaluation, below any mate
+#define STOP_CHECK_INTERVAL 1024  // Nodes between polls of the clock and tm_stop. Must be a power of 2
+
+#define NULL_MOVE_MIN_DEPTH 3
+#define LMR_MIN_DEPTH 3
+#define LMR_MIN_MOVES 3  // Moves searched at full depth before later quiet moves are reduced
+
+// Move ordering: hash move, winning captures and queen promotions by MVV-LVA, killers, then quiet moves by history
+#define HASH_MOVE_SCORE (1 << 30)
+#define CAPTURE_SCORE (1 << 24)
+#define KILLER_SCORE (1 << 20)
+#define UNDERPROMOTION_SCORE (-1)
+
+static const int piece_order_value[whiteAll] = {1, 3, 3, 5, 9, 0};  // Victim values for MVV-LVA
+
+/**
+ * Buffers for one ply of the search. Each thread allocates a stack of them from its arena when a search starts,
+ * so nodes never put move lists on the C stack or call the allocator
+ */
+struct ply_scratch {
+    struct move_info moves[MAX_MOVES];
+    int scores[MAX_MOVES];
+    struct FEN_info after;  // Child position, reused for every move of the node
+};
+
+/**
+ * Everything one search thread owns. Lives in the thread's arena (see search_arena.h) for one search
+ */
+struct search_thread {
+    int id;          // omp_get_thread_num(). Thread 0 runs the clock, multi-PV and the result; the others help
+    arena_t arena;
+    struct ply_scratch *stack;  // [MAX_PLY + 1], indexed by ply
+    stats st;        // This thread's counters (see search_stats.h)
+    uint64_t nodes;
+    uint64_t reportedNodes;  // Part of nodes already added to searched_nodes
+    bool stopped;
+    int completedDepth;
+    int rootScore;                                   // Score of pv[0][0], set as soon as the root move is searched
+    struct move_info killers[MAX_PLY][2];            // Quiet moves that caused a beta cutoff at each ply
+    int history[numPieceTypes][totalSquares];        // Quiet move cutoffs by piece and destination, depth^2 weighted
+    struct move_info pv[MAX_PLY + 1][MAX_PLY + 1];   // Triangular principal variation table
+    int pvLength[MAX_PLY + 1];
+    struct game_history game;                        // Keys of the game and the current line, top: this node
+    struct multipv mpv;                              // Lines of the last iteration that finished them all
+    int line;                                        // Multi-PV run in progress: root skips mpv lines [0, line)
+    uint16_t rootMove;                               // _move16 of the move this run searches first, or 0
+};
+
+static struct time_manager search_tm;
+static struct search_result last_result;
+static struct search_result iterations[MAX_PLY];  // Thread 0's result after each completed iteration of the last search
+static int num_iterations = 0;
+
+static int num_threads = 1;
+static uint64_t searched_nodes;  // Every thread's nodes, added at each stop poll. Atomic
+static bool helpers_stop;        // Set by thread 0 when its search is over. Atomic
+
+static struct move_info tb_root_moves[MAX_MOVES];  // Root moves the tablebases rank best, if num_tb_root_moves
+static int num_tb_root_moves = 0;
+
+static int depth_limit = 0;
+static uint64_t node_limit = 0;
+static int64_t movetime_limit = 0;
+static bool uci_output = false;
+
+static bool initialized = false;
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Fills the move generation and evaluation tables, and allocates the transposition table, on the first search,
+ * before any search thread starts
+ */
+static void _init_engine(void) {
+    if (initialized) return;
+    movegen_init();
+    evaluation_init();
+    search_arenas_init(SEARCH_ARENA_BYTES);
+    tt_init();
+    initialized = true;
+}
+
+
+void search_set_threads(int n) {
+    if (n < 1) n = 1;
+    if (n > MAX_SEARCH_THREADS) n = MAX_SEARCH_THREADS;
+    num_threads = n;
+}
+
+
+void search_set_depth(int depth) {
+    REQUIRES(depth >= 0 && depth < MAX_PLY);
+    depth_limit = depth;
+}
+
+
+void search_set_nodes(uint64_t nodes) {
+    node_limit = nodes;
+}
+
+
+void search_set_movetime(int64_t ms) {
+    REQUIRES(ms >= 0);
+    movetime_limit = ms;
+}
+
+
+void search_set_uci_output(bool on) {
+    uci_output = on;
+}
+
+
+void search_last_result(struct search_result *res) {
+    REQUIRES(res != NULL);
+    *res = last_result;
+}
+
+
+int search_iterations(struct search_result *res, int max) {
+    REQUIRES(max >= 0 && (max == 0 || res != NULL));
+    int n = (num_iterations < max) ? num_iterations : max;
+    memcpy(res, iterations, n * sizeof(struct search_result));
+    return n;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * @return Whether a and b are the same move
+ */
+static bool _same_move(move a, move b) {
+    return a->from == b->from && a->to == b->to && a->piece == b->piece && a->promotion == b->promotion;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * @return Whether the root may play m: any move, unless the tablebases ranked the root's moves
+ */
+static bool _tb_root_move(move m) {
+    if (num_tb_root_moves == 0) return true;
+    for (int i = 0; i < num_tb_root_moves; i++) {
+        if (_same_move(m, &tb_root_moves[i])) return true;
+    }
+    return false;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Packs a move into a transposition table entry's 16 bits: from | to << 6 | promotion << 12 (see tt.h), or for a
+ * crazyhouse drop, piece type | to << 6 | 1 << 15. Never 0, which is a real move's encoding only for a1a1
+ */
+static uint16_t _move16(move m) {
+#if VARIANT == VARIANT_CRAZYHOUSE
+    if (m->from == DROP_FROM) return (uint16_t) (m->piece % colorOffset | m->to << 6 | 1 << 15);
+#endif
+    return (uint16_t) (m->from | m->to << 6 | m->promotion << 12);
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Mate scores are stored relative to the node (mate in n from here), so they stay right at any ply
+ */
+static int _score_to_tt(int score, int ply) {
+    if (score >= MATE_IN_MAX_PLY) return score + ply;
+    if (score <= -MATE_IN_MAX_PLY) return score - ply;
+    return score;
+}
+
+static int _score_from_tt(int score, int ply) {
+    if (score >= MATE_IN_MAX_PLY) return score - ply;
+    if (score <= -MATE_IN_MAX_PLY) return score + ply;
+    return score;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Polls the clock, tm_stop and the node limit (over all threads) every STOP_CHECK_INTERVAL nodes. The first
+ * iteration always completes, so there is a move to play however little time is left. Helper threads only
+ * poll helpers_stop
+ * @return Whether the search must unwind
+ */
+static bool _should_stop(struct search_thread *t) {
+    if (t->stopped) return true;
+    if (t->nodes & (STOP_CHECK_INTERVAL - 1)) return false;
+    uint64_t total = __atomic_add_fetch(&searched_nodes, t->nodes - t->reportedNodes, __ATOMIC_RELAXED);
+    t->reportedNodes = t->nodes;
+    if (t->id != 0) t->stopped = __atomic_load_n(&helpers_stop, __ATOMIC_RELAXED);
+    else if (t->completedDepth > 0) t->stopped = (node_limit && total >= node_limit) || tm_out_of_time(&search_tm);
+    return t->stopped;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * @return Nodes of every thread so far, as far as thread t knows
+ */
+static uint64_t _searched_nodes(struct search_thread *t) {
+    return __atomic_load_n(&searched_nodes, __ATOMIC_RELAXED) + t->nodes - t->reportedNodes;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * @return Whether the side to move has a piece other than pawns and king, so a null move is unlikely to be zugzwang
+ */
+static bool _has_non_pawn_material(FEN position) {
+    int us = position->whiteToMove ? 0 : colorOffset;
+    return (position->BBoard[whiteKnights + us] | position->BBoard[whiteBishops + us]
+            | position->BBoard[whiteRooks + us] | position->BBoard[whiteQueens + us]) != 0;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * @return Whether m neither captures nor promotes to a queen, which is what killers, history and LMR apply to
+ */
+static bool _is_quiet(FEN position, move m) {
+    bool queenPromotion = (m->piece % colorOffset == whitePawns) && (m->to < a2 || m->to > h7)
+                          && (m->promotion == 0 || m->promotion == whiteQueens);
+    return !queenPromotion && captured_piece(position, m) == numPieceTypes;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Gives each move an ordering score
+ * @param hashMove _move16 of the move to search first, or 0
+ */
+static void _score_moves(struct search_thread *t, FEN position, struct move_info *moves, int *scores, int n,
+                         uint16_t hashMove, int ply) {
+    for (int i = 0; i < n; i++) {
+        move m = &moves[i];
+        enum EPieceType victim = captured_piece(position, m);
+        bool promotion = (m->piece % colorOffset == whitePawns) && (m->to < a2 || m->to > h7);
+        if (hashMove && _move16(m) == hashMove) scores[i] = HASH_MOVE_SCORE;
+        else if (promotion && m->promotion && m->promotion != whiteQueens) scores[i] = UNDERPROMOTION_SCORE;
+        else if (victim != numPieceTypes || promotion) {
+            int value = (victim == numPieceTypes) ? 0 : piece_order_value[victim % colorOffset];
+            if (promotion) value += piece_order_value[whiteQueens];
+            scores[i] = CAPTURE_SCORE + 16 * value - piece_order_value[m->piece % colorOffset];
+        }
+        else if (_same_move(m, &t->killers[ply][0])) scores[i] = KILLER_SCORE + 1;
+        else if (_same_move(m, &t->killers[ply][1])) scores[i] = KILLER_SCORE;
+        else scores[i] = t->history[m->piece][m->to];
+    }
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Selection sort step: swaps the best-scored move from i onwards into i
+ */
+static void _pick_move(struct move_info *moves, int *scores, int n, int i) {
+    int best = i;
+    for (int j = i + 1; j < n; j++) {
+        if (scores[j] > scores[best]) best = j;
+    }
+    struct move_info m = moves[i];
+    moves[i] = moves[best];
+    moves[best] = m;
+    int s = scores[i];
+    scores[i] = scores[best];
+    scores[best] = s;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Quiescence search: captures and queen promotions only (every move when in check), until the position is quiet
+ */
+static int _qsearch(struct search_thread *t, FEN position, int alpha, int beta, int ply) {
+    if (_should_stop(t)) return 0;
+    t->nodes++;
+    STATS_INC(t->st, nodes);
+    STATS_INC(t->st, qnodes);
+    if (variant_lost(position)) return -MATE_SCORE + ply;
+    if (ply >= MAX_PLY) return evaluate(position);
+
+    bool check = in_check(position);
+    int best = -INFINITE_SCORE;
+    if (!check) {
+        best = evaluate(position);  // Stand pat: the side to move need not capture
+        if (best >= beta) return best;
+        if (best > alpha) alpha = best;
+    }
+
+    struct ply_scratch *scratch = &t->stack[ply];
+    move moves = scratch->moves;
+    int *scores = scratch->scores;
+    int n = check ? generate_pseudo_moves(position, moves) : generate_captures(position, moves);
+    _score_moves(t, position, moves, scores, n, 0, ply);
+    int legal = 0;
+    for (int i = 0; i < n; i++) {
+        _pick_move(moves, scores, n, i);
+        FEN after = &scratch->after;
+        *after = *position;
+        play_move(after, &moves[i]);
+        if (mover_in_check(after)) continue;
+        legal++;
+
+        int score = -_qsearch(t, after, -beta, -alpha, ply + 1);
+        if (t->stopped) return 0;
+        if (score > best) {
+            best = score;
+            if (score > alpha) alpha = score;
+            if (score >= beta) break;
+        }
+    }
+    if (check && !legal) return -MATE_SCORE + ply;
+    return best;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Principal variation search with null-move pruning and late move reductions
+ * @param t
+ * @param position
+ * @param alpha
+ * @param beta
+ * @param depth Remaining depth. The quiescence search takes over at 0
+ * @param ply Distance from the root
+ * @param nullAllowed false right after a null move, so two are never made in a row
+ * @return Score from the side to move's perspective, or 0 once t->stopped is set
+ */
+static int _search(struct search_thread *t, FEN position, int alpha, int beta, int depth, int ply, bool nullAllowed) {
+    t->pvLength[ply] = ply;
+    if (depth <= 0) return _qsearch(t, position, alpha, beta, ply);
+    if (_should_stop(t)) return 0;
+    t->nodes++;
+    STATS_INC(t->st, nodes);
+
+    bool root = ply == 0;
+    bool pvNode = beta - alpha > 1;
+    if (!root) {
+        if (variant_lost(position)) return -MATE_SCORE + ply;
+        if (history_is_draw(&t->game, position)) return 0;
+
+        // Mate distance pruning: no line from here beats a mate already found closer to the root
+        if (alpha < -MATE_SCORE + ply) alpha = -MATE_SCORE + ply;
+        if (beta > MATE_SCORE - ply - 1) beta = MATE_SCORE - ply - 1;
+        if (alpha >= beta) return alpha;
+        if (ply >= MAX_PLY) return evaluate(position);
+    }
+
+    // A stored result at least this deep settles the node outright, except on the principal variation
+    uint64_t key = t->game.keys[t->game.length - 1];
+    uint16_t hashMove = 0;
+    STATS_INC(t->st, ttProbes);
+    struct tt_data entry;
+    if (tt_probe(key, &entry)) {
+        STATS_INC(t->st, ttHits);
+        hashMove = entry.move;
+        int score = _score_from_tt(entry.score, ply);
+        if (!pvNode && entry.depth >= depth && (entry.bound == ttExact
+                                                || (entry.bound == ttLower && score >= beta)
+                                                || (entry.bound == ttUpper && score <= alpha))) {
+            return score;
+        }
+    }
+
+    // Tablebases: exact results, but only once a capture or pawn move has reset the 50-move count
+    if (!root && position->halfMove == 0 && !position->castling
+        && popCount(position->BBoard[whiteAll] | position->BBoard[blackAll]) <= tb_largest()) {
+        int wdl;
+        STATS_INC(t->st, tbProbes);
+        if (tb_probe_wdl(position, &wdl)) {
+            STATS_INC(t->st, tbHits);
+            // Cursed wins and blessed losses are draws under the 50-move rule, just better or worse ones
+            int score = (wdl == tbWin) ? TB_WIN_SCORE - ply : (wdl == tbLoss) ? -TB_WIN_SCORE + ply : 2 * wdl;
+            enum ttBound bound = (wdl == tbWin) ? ttLower : (wdl == tbLoss) ? ttUpper : ttExact;
+            if (bound == ttExact || (bound == ttLower && score >= beta) || (bound == ttUpper && score <= alpha)) {
+                tt_store(key, 0, score, (depth + 6 < INT8_MAX) ? depth + 6 : INT8_MAX, bound);
+                return score;
+            }
+        }
+    }
+
+    // Bitbases: king + pawn, rook or queen vs king is a known win or an exact draw
+    int bitbaseResult;
+    if (!root && bitbase_probe(position, &bitbaseResult)) {
+        int score = bitbaseResult * KNOWN_WIN;
+        if (bitbaseResult == 0 || (bitbaseResult > 0 && score >= beta) || (bitbaseResult < 0 && score <= alpha)) {
+            return score;
+        }
+    }
+    int originalAlpha = alpha;
+
+    bool check = in_check(position);
+    if (check) depth++;  // Check extension
+
+    // Null move: if passing still fails high, a real move surely would. Unsafe in zugzwang, so never with only pawns
+    if (nullAllowed && !pvNode && !check && depth >= NULL_MOVE_MIN_DEPTH && _has_non_pawn_material(position)
+        && evaluate(position) >= beta) {
+        FEN after = &t->stack[ply].after;
+        *after = *position;
+        play_null_move(after);
+        history_push(&t->game, history_key(after));
+        int score = -_search(t, after, -beta, -beta + 1, depth - 1 - (2 + depth / 4), ply + 1, false);
+        history_pop(&t->game);
+        if (t->stopped) return 0;
+        if (score >= beta) {
+            STATS_INC(t->st, nullMoveCutoffs);
+            return (score >= MATE_IN_MAX_PLY) ? beta : score;  // Unproven mates are not trusted
+        }
+    }
+
+    struct ply_scratch *scratch = &t->stack[ply];
+    move moves = scratch->moves;
+    int *scores = scratch->scores;
+    int n = generate_pseudo_moves(position, moves);
+    if (root && t->rootMove) hashMove = t->rootMove;  // This line's move from the previous iteration first
+    _score_moves(t, position, moves, scores, n, hashMove, ply);
+
+    int best = -INFINITE_SCORE;
+    uint16_t bestMove = 0;
+    int legal = 0;
+    for (int i = 0; i < n; i++) {
+        _pick_move(moves, scores, n, i);
+        move m = &moves[i];
+        if (root && (multipv_excluded(&t->mpv, t->line, m) || !_tb_root_move(m))) continue;
+        FEN after = &scratch->after;
+        *after = *position;
+        play_move(after, m);
+        if (mover_in_check(after)) continue;
+        legal++;
+        history_push(&t->game, history_key(after));
+
+        bool quiet = _is_quiet(position, m);
+        int score;
+        if (legal == 1) score = -_search(t, after, -beta, -alpha, depth - 1, ply + 1, true);
+        else {
+            // Late quiet moves are probably bad: search them shallower, and again at full depth if they beat alpha
+            int reduction = 0;
+            if (depth >= LMR_MIN_DEPTH && legal > LMR_MIN_MOVES && quiet && !check && !in_check(after)) {
+                reduction = (legal > 2 * LMR_MIN_MOVES + depth) ? 2 : 1;
+            }
+            score = -_search(t, after, -alpha - 1, -alpha, depth - 1 - reduction, ply + 1, true);
+            if (score > alpha && reduction) {
+                STATS_INC(t->st, lmrResearches);
+                score = -_search(t, after, -alpha - 1, -alpha, depth - 1, ply + 1, true);
+            }
+            if (score > alpha && score < beta) score = -_search(t, after, -beta, -alpha, depth - 1, ply + 1, true);
+        }
+        history_pop(&t->game);
+        if (t->stopped) return 0;
+
+        if (score > best) {
+            best = score;
+            bestMove = _move16(m);
+            if (score > alpha) {
+                alpha = score;
+                t->pv[ply][ply] = *m;
+                for (int j = ply + 1; j < t->pvLength[ply + 1]; j++) t->pv[ply][j] = t->pv[ply + 1][j];
+                t->pvLength[ply] = (t->pvLength[ply + 1] > ply + 1) ? t->pvLength[ply + 1] : ply + 1;
+                if (root) t->rootScore = score;
+            }
+            if (score >= beta) {
+                STATS_INC(t->st, betaCutoffs);
+                if (legal == 1) STATS_INC(t->st, firstMoveCutoffs);
+                if (quiet) {
+                    if (!_same_move(m, &t->killers[ply][0])) {
+                        t->killers[ply][1] = t->killers[ply][0];
+                        t->killers[ply][0] = *m;
+                    }
+                    t->history[m->piece][m->to] += depth * depth;
+                    if (t->history[m->piece][m->to] >= KILLER_SCORE) {  // Keep history below the killers
+                        for (int p = 0; p < numPieceTypes; p++) {
+                            for (int sq = 0; sq < totalSquares; sq++) t->history[p][sq] /= 2;
+                        }
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+    if (!legal) return check ? -MATE_SCORE + ply : 0;  // Checkmate or stalemate
+
+    enum ttBound bound = (best >= beta) ? ttLower : (best > originalAlpha) ? ttExact : ttUpper;
+    if (bound == ttUpper) bestMove = 0;  // Every move failed low: none of them is known to be best
+    if (!root || t->line == 0) {  // Later multi-PV runs skip root moves, so their root result is not the position's
+        tt_store(key, bestMove, _score_to_tt(best, ply), (depth < INT8_MAX) ? depth : INT8_MAX, bound);
+    }
+    return best;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Stores the line a root run just finished in t->mpv
+ */
+static void _store_line(struct search_thread *t, int depth) {
+    struct pv_line line;
+    line.score = t->rootScore;
+    line.depth = depth;
+    line.length = (t->pvLength[0] < MAX_PV_LENGTH) ? t->pvLength[0] : MAX_PV_LENGTH;
+    memcpy(line.moves, t->pv[0], line.length * sizeof(struct move_info));
+    multipv_store(&t->mpv, &line);
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Prints the UCI info lines for an iteration: depth, score and principal variation (one line per multi-PV line),
+ * then the search statistics
+ */
+static void _print_info(struct search_thread *t, int depth, int score) {
+    int64_t elapsed = tm_elapsed(&search_tm);
+    if (t->mpv.numLines > 1) {
+        char line[MAX_PV_LENGTH * 8 + 64];
+        for (int i = 0; i < t->mpv.found; i++) {
+            multipv_info_string(&t->mpv, i, line, sizeof(line));
+            printf("%s\n", line);
+        }
+    }
+    else {
+        char pv[MAX_PLY * 6 + 1] = "";
+        int length = 0;
+        for (int i = 0; i < t->pvLength[0]; i++) {
+            pv[length++] = ' ';
+            length += move_to_uci(&t->pv[0][i], pv + length);
+        }
+        int mateScore = (score < 0) ? -score : score;
+        if (mateScore >= MATE_IN_MAX_PLY) {
+            int moves = (MATE_SCORE - mateScore + 1) / 2;
+            printf("info depth %d score mate %d nodes %" PRIu64 " time %" PRId64 " pv%s\n",
+                   depth, (score > 0) ? moves : -moves, _searched_nodes(t), elapsed, pv);
+        }
+        else {
+            printf("info depth %d score cp %d nodes %" PRIu64 " time %" PRId64 " pv%s\n",
+                   depth, score, _searched_nodes(t), elapsed, pv);
+        }
+    }
+
+    struct search_stats total;
+    char info[256];
+    stats_aggregate(&total);
+    stats_info_string(&total, (uint64_t) elapsed, info, sizeof(info));
+    printf("%s\n", info);
+    fflush(stdout);
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Sets up the calling thread's state for a search, in its own arena
+ */
+static struct search_thread *_new_thread(int id, FEN position) {
+    arena_t A = search_arena(id);
+    struct search_thread *t = ARENA_NEW0(A, struct search_thread, 1);
+    t->id = id;
+    t->arena = A;
+    t->stack = ARENA_NEW(A, struct ply_scratch, MAX_PLY + 1);
+    t->st = stats_for_thread(id);
+    history_start(&t->game, history_key(position));
+    multipv_start(&t->mpv);
+    return t;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Iterative deepening of thread 0, which owns the clock, multi-PV, the UCI output and the result
+ * @param moves Legal root moves
+ * @param n At least 1
+ */
+static void _main_search(struct search_thread *t, FEN position, move moves, int n, int maxDepth,
+                         struct search_result *res) {
+    int numLines = (t->mpv.numLines < n) ? t->mpv.numLines : n;
+    struct move_info best = moves[0];
+    for (int depth = 1; depth <= maxDepth; depth++) {
+        struct multipv previous = t->mpv;
+        multipv_start(&t->mpv);
+        bool changed = false;
+        for (t->line = 0; t->line < numLines && !t->stopped; t->line++) {
+            t->rootMove = (previous.found > t->line) ? _move16(&previous.lines[t->line].moves[0]) : 0;
+            t->pvLength[0] = 0;
+            _search(t, position, -INFINITE_SCORE, INFINITE_SCORE, depth, 0, false);
+            if (t->pvLength[0] == 0) continue;
+
+            // An interrupted iteration still counts if it finished a root move that beat the earlier best
+            if (t->line == 0) {
+                changed = !_same_move(&best, &t->pv[0][0]);
+                best = t->pv[0][0];
+                res->score = t->rootScore;
+            }
+            if (!t->stopped) _store_line(t, depth);
+        }
+        if (t->stopped) {
+            t->mpv = previous;  // Report the last complete set of lines
+            break;
+        }
+        t->completedDepth = res->depth = depth;
+        if (uci_output) _print_info(t, depth, res->score);
+        struct search_result *iteration = &iterations[num_iterations++];
+        move_to_uci(&best, iteration->move);
+        iteration->score = res->score;
+        iteration->depth = depth;
+        iteration->nodes = _searched_nodes(t);
+        iteration->time = tm_elapsed(&search_tm);
+
+        if (n == 1 && search_tm.limited) break;  // Forced move: nothing to think about
+        int mateScore = (res->score < 0) ? -res->score : res->score;
+        if (mateScore >= MATE_IN_MAX_PLY && MATE_SCORE - mateScore <= depth) break;  // Shortest mate proven
+        if (!tm_iteration_done(&search_tm, changed)) break;
+    }
+
+    // A ponder search keeps its move until the opponent moves: ponder hit (then the clock runs) or tm_stop
+    struct timespec tick = {0, 1000000};
+    while (search_tm.pondering && !tm_out_of_time(&search_tm)) nanosleep(&tick, NULL);
+    move_to_uci(&best, res->move);
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Lazy SMP helper: searches the same root with its own killers and history until thread 0 is done. Odd helpers
+ * start a ply deeper, so threads spread over depths. Their results reach thread 0 only through the shared
+ * transposition table
+ */
+static void _helper_search(struct search_thread *t, FEN position, int maxDepth) {
+    for (int depth = 1 + (t->id & 1); depth <= maxDepth && !t->stopped; depth++) {
+        _search(t, position, -INFINITE_SCORE, INFINITE_SCORE, depth, 0, false);
+    }
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * When the tablebases cover the root, keeps only the moves they rank best by DTZ, so a won position is never
+ * thrown away and a lost one is dragged out. The search then picks among those
+ * @param moves Legal root moves. The kept ones are moved to the front
+ * @param n Number of moves
+ * @return Number of moves kept
+ */
+static int _tb_filter_root(FEN position, struct move_info *moves, int n) {
+    num_tb_root_moves = 0;
+    if (position->castling || popCount(position->BBoard[whiteAll] | position->BBoard[blackAll]) > tb_largest()) {
+        return n;
+    }
+    stats st = stats_for_thread(0);
+    int ranks[MAX_MOVES];
+    STATS_INC(st, tbProbes);
+    if (!tb_rank_root_moves(position, moves, n, ranks)) return n;
+    STATS_INC(st, tbHits);
+
+    int best = ranks[0];
+    for (int i = 1; i < n; i++) {
+        if (ranks[i] > best) best = ranks[i];
+    }
+    int kept = 0;
+    for (int i = 0; i < n; i++) {
+        if (ranks[i] == best) moves[kept++] = moves[i];
+    }
+    if (kept < n) {
+        memcpy(tb_root_moves, moves, kept * sizeof(struct move_info));
+        num_tb_root_moves = kept;
+    }
+    return kept;
+}
+
+
+void search_position(FEN position, struct search_result *res) {
+    REQUIRES(position != NULL && res != NULL);
+    _init_engine();
+    search_arenas_reset();
+    stats_reset();
+    tt_new_search();
+    tm_start(&search_tm);
+    if (movetime_limit && !search_tm.pondering) {
+        search_tm.limited = true;
+        search_tm.soft = search_tm.hard = movetime_limit;
+    }
+
+    memset(res, 0, sizeof(*res));
+    num_iterations = 0;
+    struct move_info moves[MAX_MOVES];
+    int n = _tb_filter_root(position, moves, generate_moves(position, moves));
+    if (n == 0) {
+        struct multipv none;
+        multipv_start(&none);
+        multipv_publish(&none);
+    }
+    else {
+        bool bounded = search_tm.limited || search_tm.pondering || node_limit;
+        int maxDepth = depth_limit ? depth_limit : bounded ? MAX_PLY - 1 : DEFAULT_SEARCH_DEPTH;
+        uint64_t nodes = 0;
+        __atomic_store_n(&searched_nodes, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&helpers_stop, false, __ATOMIC_RELAXED);
+
+        #pragma omp parallel num_threads(num_threads) reduction(+:nodes)
+        {
+            int id = omp_get_thread_num();
+            affinity_pin_thread(id);  // Before the thread first touches its arena, so the memory is on its node
+            struct search_thread *t = _new_thread(id, position);
+            if (id == 0) {
+                _main_search(t, position, moves, n, maxDepth, res);
+                multipv_publish(&t->mpv);
+                __atomic_store_n(&helpers_stop, true, __ATOMIC_RELAXED);
+            }
+            else _helper_search(t, position, maxDepth);
+            nodes += t->nodes;
+        }
+        res->nodes = nodes;
+    }
+    res->time = tm_elapsed(&search_tm);
+    last_result = *res;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Empties search_last_result, search_iterations and the multi-PV lines, so a call that fails before searching
+ * reports no move instead of the previous search's
+ */
+static void _forget_last_search(void) {
+    memset(&last_result, 0, sizeof(last_result));
+    num_iterations = 0;
+    struct multipv none;
+    multipv_start(&none);
+    multipv_publish(&none);
+}
+
+
+char *lichess(const char *fen, const char *moves) {
+    static char res[8];
+    res[0] = '\0';
+    _forget_last_search();
+    if (fen == NULL) return res;
+    _init_engine();
+
+    struct FEN_info position;
+    if (parse_fen(fen, &position) == NULL) return res;
+    for (const char *uci = moves; uci && *uci; ) {
+        if (*uci == ' ') {
+            uci++;
+            continue;
+        }
+        struct move_info m;
+        if (!parse_uci_move(&position, uci, &m)) return res;
+        play_move(&position, &m);
+        uci += strcspn(uci, " ");
+    }
+
+    struct search_result result;
+    search_position(&position, &result);
+    strcpy(res, result.move);
+    return res;
+}
@@ -0,0 +1,78 @@
+//
+// Search: iterative deepening over a principal variation alpha-beta search, and the lichess() entry point.
+//
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef CHESS_SEARCH_H
+#define CHESS_SEARCH_H
+
+#define MAX_PLY 128
+#define MATE_SCORE 30000  // Mate at the root. Mate in n plies scores MATE_SCORE - n, so it fits a TT entry's int16
+#define MATE_IN_MAX_PLY (MATE_SCORE - MAX_PLY)
+#define DEFAULT_SEARCH_DEPTH 6  // Depth searched when nothing else (clock, node or time limit) bounds the search
+
+/**
+ * Outcome of the last search. Field order is part of the shared library API (mirrored by ctypes structures)
+ */
+struct search_result {
+    char move[8];      // Best move in UCI format, or "" if the position has no legal moves
+    int score;         // Centipawns from the side to move's perspective. Mates are beyond +-MATE_IN_MAX_PLY
+    int depth;         // Last completed iteration
+    uint64_t nodes;
+    int64_t time;      // ms
+};
+
+/**
+ * Sets the number of threads later searches use (Lazy SMP: helpers search the same root and share the
+ * transposition table). Exported for the Python (ctypes) side
+ * @param n Clamped to [1, MAX_SEARCH_THREADS]
+ */
+void search_set_threads(int n);
+
+/**
+ * Search limits, kept for every later search until changed. 0 means no limit.
+ * A search stops at whichever of these, the clock (see timeman.h) or tm_stop comes first
+ */
+void search_set_depth(int depth);
+void search_set_nodes(uint64_t nodes);
+void search_set_movetime(int64_t ms);
+
+/**
+ * @param on Whether to print UCI "info" lines (score, principal variation and search statistics) to stdout
+ * after every iteration, as the command line engine does
+ */
+void search_set_uci_output(bool on);
+
+/**
+ * @param res Receives the outcome of the last search. Exported for the Python (ctypes) side
+ */
+void search_last_result(struct search_result *res);
+
+/**
+ * Exported for the Python (ctypes) side, ie. to time when a test position's solution first appeared
+ * @param res Buffer of max results, filled with the last search's best move, score, depth, nodes and time after
+ * each completed iteration, shallowest first
+ * @param max Size of res. MAX_PLY always fits every iteration
+ * @return Number of iterations written
+ */
+int search_iterations(struct search_result *res, int max);
+
+/**
+ * Searches a position, for as long as the limits above and the clock set with tm_set_clock allow
+ * @param position Not modified
+ * @param res Receives the outcome
+ */
+void search_position(FEN position, struct search_result *res);
+
+/**
+ * Shared library entry point, called by the Python (ctypes) side
+ * @param fen Position to search
+ * @param moves Space-separated UCI moves to play from fen first (ie. "e2e4 e7e5"), or ""
+ * @return Best move in UCI format, or "" if the FEN or a move is malformed, or there is no legal move.
+ * Valid until the next call. A malformed FEN or move also empties search_last_result and the multi-PV lines
+ */
+char *lichess(const char *fen, const char *moves);
+
+#endif //CHESS_SEARCH_H
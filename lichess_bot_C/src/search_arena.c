@@ -0,0 +1,76 @@
+//
+// Per-thread arenas for everything a search allocates: no malloc / free (and no allocator lock) once it starts.
+//
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "lib/contracts.h"
+#include "lib/arena.h"
+#include "dataStructs.h"
+#include "search_stats.h"
+#include "multipv.h"
+#include "search_arena.h"
+
+/**
+ * Arena headers are written on every allocation, so each thread's sits on its own cache line
+ */
+struct padded_arena {
+    struct arena a;
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+static struct padded_arena arenas[MAX_SEARCH_THREADS];
+static size_t arena_bytes = 0;  // 0 until search_arenas_init
+
+
+void search_arenas_init(size_t bytes) {
+    REQUIRES(bytes > 0);
+    if (arena_bytes == 0) arena_bytes = bytes;
+}
+
+
+void search_arenas_reset(void) {
+    for (int i = 0; i < MAX_SEARCH_THREADS; i++) {
+        if (arenas[i].a.base != NULL) arena_reset(&arenas[i].a);
+    }
+}
+
+
+arena_t search_arena(int thread) {
+    REQUIRES(arena_bytes > 0 && 0 <= thread && thread < MAX_SEARCH_THREADS);
+    // Reserved by the thread's first search, so with pinning (affinity.h) its pages are first touched on its own node
+    if (arenas[thread].a.base == NULL) arena_init(&arenas[thread].a, arena_bytes);
+    return &arenas[thread].a;
+}
+
+
+move arena_move_list(arena_t A, int n) {
+    REQUIRES(n >= 0);
+    return ARENA_NEW(A, struct move_info, n);
+}
+
+
+struct pv_line *arena_pv_line(arena_t A) {
+    struct pv_line *res = ARENA_NEW(A, struct pv_line, 1);
+    res->length = 0;
+    return res;
+}
+
+
+uint64_t *arena_bitboards(arena_t A) {
+    return ARENA_NEW(A, uint64_t, numPieceTypes);
+}
+
+
+FEN arena_fen(arena_t A) {
+    return ARENA_NEW(A, struct FEN_info, 1);
+}
+
+
+node arena_list_node(arena_t A, void *data, node next) {
+    node res = ARENA_NEW(A, struct Node, 1);
+    res->data = data;
+    res->next = next;
+    return res;
+}
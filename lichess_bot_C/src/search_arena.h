@@ -0,0 +1,41 @@
+//
+// Per-thread arenas for everything a search allocates: no malloc / free (and no allocator lock) once it starts.
+//
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef CHESS_SEARCH_ARENA_H
+#define CHESS_SEARCH_ARENA_H
+
+#define SEARCH_ARENA_BYTES ((size_t) 4 << 20)  // Per thread. See arena highWater if searches need more
+
+/**
+ * Sets the size of each thread's arena. Call once at startup, before any search
+ * @param bytes Per thread, ie. SEARCH_ARENA_BYTES
+ */
+void search_arenas_init(size_t bytes);
+
+/**
+ * Frees every thread's allocations. Call between searches, never during one
+ */
+void search_arenas_reset(void);
+
+/**
+ * Reserves the arena on first use, so call it from the thread that owns it, after pinning it (affinity.h)
+ * @param thread index in [0, MAX_SEARCH_THREADS), ie. omp_get_thread_num()
+ * @return That thread's arena. Look it up once per search, not per node
+ */
+arena_t search_arena(int thread);
+
+/**
+ * Typed helpers. Memory lives until the arena is reset, or released back to an arena_mark
+ * (ie. mark on make, release on unmake for per-ply scratch)
+ */
+move arena_move_list(arena_t A, int n);        // n moves, uninitialized
+struct pv_line *arena_pv_line(arena_t A);      // Empty PV (length 0)
+uint64_t *arena_bitboards(arena_t A);          // Copy of a board: numPieceTypes bitboards, uninitialized
+FEN arena_fen(arena_t A);                      // Position, uninitialized
+node arena_list_node(arena_t A, void *data, node next);
+
+#endif //CHESS_SEARCH_ARENA_H
@@ -0,0 +1,54 @@
+//
+// Per-thread search statistics, aggregated on demand.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "lib/contracts.h"
+#include "search_stats.h"
+
+struct padded_search_stats thread_stats[MAX_SEARCH_THREADS];
+
+
+stats stats_for_thread(int thread) {
+    REQUIRES(0 <= thread && thread < MAX_SEARCH_THREADS);
+    return &thread_stats[thread].counters;
+}
+
+
+void stats_reset(void) {
+    memset(thread_stats, 0, sizeof(thread_stats));
+}
+
+
+void stats_aggregate(stats res) {
+    REQUIRES(res != NULL);
+    memset(res, 0, sizeof(struct search_stats));
+    for (int t = 0; t < MAX_SEARCH_THREADS; t++) {
+        stats st = &thread_stats[t].counters;
+        res->nodes += st->nodes;
+        res->qnodes += st->qnodes;
+        res->ttProbes += st->ttProbes;
+        res->ttHits += st->ttHits;
+        res->betaCutoffs += st->betaCutoffs;
+        res->firstMoveCutoffs += st->firstMoveCutoffs;
+        res->nullMoveCutoffs += st->nullMoveCutoffs;
+        res->lmrResearches += st->lmrResearches;
+        res->tbProbes += st->tbProbes;
+        res->tbHits += st->tbHits;
+    }
+}
+
+
+int stats_info_string(stats total, uint64_t elapsed_ms, char *res, size_t size) {
+    REQUIRES(total != NULL && res != NULL);
+    uint64_t nps = total->nodes * 1000 / (elapsed_ms ? elapsed_ms : 1);
+    double firstcut = total->betaCutoffs ? 100.0 * total->firstMoveCutoffs / total->betaCutoffs : 0.0;
+    return snprintf(res, size,
+                    "info nodes %" PRIu64 " nps %" PRIu64 " tbhits %" PRIu64 " string qnodes %" PRIu64 " tthits %" PRIu64 "/%" PRIu64
+                    " betacuts %" PRIu64 " firstcut %.1f%% nullcuts %" PRIu64 " lmrresearch %" PRIu64,
+                    total->nodes, nps, total->tbHits, total->qnodes, total->ttHits, total->ttProbes,
+                    total->betaCutoffs, firstcut, total->nullMoveCutoffs, total->lmrResearches);
+}
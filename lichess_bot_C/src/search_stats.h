@@ -0,0 +1,80 @@
+//
+// Per-thread search statistics, aggregated on demand.
+//
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef CHESS_SEARCH_STATS_H
+#define CHESS_SEARCH_STATS_H
+
+#define CACHE_LINE_SIZE 64
+#define MAX_SEARCH_THREADS 64
+
+/**
+ * Counters for one search thread, or the sum over all of them.
+ * Field order is part of the shared library API (mirrored by ctypes structures), so only append
+ */
+struct search_stats {
+    uint64_t nodes;             // Every node visited, including quiescence nodes
+    uint64_t qnodes;            // Quiescence nodes
+    uint64_t ttProbes;          // Transposition table lookups
+    uint64_t ttHits;            // ... that found an entry for this position
+    uint64_t betaCutoffs;       // Nodes that failed high
+    uint64_t firstMoveCutoffs;  // ... on the first move searched (measures move ordering)
+    uint64_t nullMoveCutoffs;   // Null-move searches that failed high
+    uint64_t lmrResearches;     // Late-move reductions that had to be re-searched at full depth
+    uint64_t tbProbes;          // Syzygy tablebase lookups (see tbprobe.h)
+    uint64_t tbHits;            // ... that the tables covered
+};
+typedef struct search_stats *stats;
+
+/**
+ * Each thread's counters sit on their own cache lines (the alignment pads the struct), so increments never false-share
+ */
+struct padded_search_stats {
+    struct search_stats counters;
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+extern struct padded_search_stats thread_stats[MAX_SEARCH_THREADS];
+
+/**
+ * Increment a counter of a thread's stats. Compile with -DNO_SEARCH_STATS to remove them entirely.
+ * Searches should look up their stats pointer once (ie. stats_for_thread(omp_get_thread_num())),
+ * not once per increment
+ */
+#ifdef NO_SEARCH_STATS
+#define STATS_INC(st, field) ((void)0)
+#else
+#define STATS_INC(st, field) ((st)->field++)
+#endif
+
+/**
+ * @param thread index in [0, MAX_SEARCH_THREADS), ie. omp_get_thread_num()
+ * @return That thread's counters
+ */
+stats stats_for_thread(int thread);
+
+/**
+ * Zero every thread's counters. Call before starting a search
+ */
+void stats_reset(void);
+
+/**
+ * Sums all threads' counters into res. Approximate if a search is still running
+ * @param res Caller-provided struct. Exported for the Python (ctypes) side
+ */
+void stats_aggregate(stats res);
+
+/**
+ * Formats aggregated stats as a UCI info line, ie.
+ * "info nodes 1234 nps 5678 tbhits 0 string qnodes 12 tthits 3/4 betacuts 5 firstcut 80.0% nullcuts 1 lmrresearch 2"
+ * @param total Aggregated stats
+ * @param elapsed_ms Time spent searching, for nodes per second
+ * @param res Buffer
+ * @param size Size of res
+ * @return Number of characters written (as snprintf)
+ */
+int stats_info_string(stats total, uint64_t elapsed_ms, char *res, size_t size);
+
+#endif //CHESS_SEARCH_STATS_H
@@ -0,0 +1,1064 @@
+//
+// Syzygy tablebases: discovery, read-only memory maps shared by every search thread, and WDL / DTZ probes.
+// Decoding follows the reference implementation by Ronald de Man (as in Stockfish's tbprobe.cpp).
+//
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "lib/contracts.h"
+#include "lib/xalloc.h"
+#include "dataStructs.h"
+#include "board_manipulations.h"
+#include "movegen.h"
+#include "tbprobe.h"
+
+#define TB_NAME_LENGTH (2 * TB_MAX_PIECES + 2)
+#define TB_MAX_SYMBOLS 4096  // Symbols are 12 bits
+#define TB_MAX_FILES 4       // Tables with pawns are split by the leading pawn's file, a to d
+
+/**
+ * Flags of a compressed sub-table
+ */
+enum tbFlag {
+    tbSTM=1,           // DTZ: side to move the sub-table stores (0 white)
+    tbMapped=2,        // DTZ: values go through the map
+    tbWinPlies=4,      // DTZ: wins are stored in plies, not moves
+    tbLossPlies=8,
+    tbWide=16,         // DTZ: the map holds 16 bit values
+    tbSingleValue=128  // Every position has the same value
+};
+
+/**
+ * Outcome of a probe, besides its value
+ */
+enum tbState {
+    tbFail=0,          // No table, or a broken one
+    tbOK=1,
+    tbChangeSTM=2,     // DTZ stores the other side to move: search one ply
+    tbZeroingBest=3    // The best move is a capture or pawn move, so DTZ holds no useful value
+};
+
+/**
+ * One compressed sub-table (PairsData in the reference code): a side to move and, with pawns, a leading pawn file.
+ * Values are Huffman coded symbols, each expanding to one or more values (Re-Pair), in fixed size blocks
+ */
+struct tb_pairs {
+    uint8_t flags;
+    uint8_t minSymLen;     // Shortest code in bits, or the value of every position with tbSingleValue
+    uint8_t maxSymLen;
+    uint32_t numBlocks;
+    size_t blockSize;      // Bytes per block
+    size_t span;           // Positions between sparse index entries
+    const unsigned char *lowestSym;    // uint16 per code length: its lowest symbol
+    const unsigned char *btree;        // 3 bytes per symbol: the two symbols it expands to (12 bits each)
+    const unsigned char *sparseIndex;  // 6 bytes per entry: block (uint32) and offset in it (uint16)
+    size_t sparseIndexSize;
+    const unsigned char *blockLength;  // uint16 per block: positions in it, minus one
+    uint32_t blockLengthSize;
+    const unsigned char *data;         // Blocks
+    const unsigned char *end;          // End of the file, so reads near the last block stay inside it
+    uint64_t *base64;      // Per code length: its lowest code, left aligned in 64 bits
+    uint8_t *symlen;       // Per symbol: values it expands to, minus one
+    int numSyms;
+    int pieces[TB_MAX_PIECES];             // Table piece codes (1-6 white pawn to king, 9-14 black) in encoding order
+    int groupLen[TB_MAX_PIECES + 1];       // Pieces per group, 0 terminated (ie. KRvKN: 3, 1, 0)
+    uint64_t groupIdx[TB_MAX_PIECES + 1];  // Index multiplier of each group. The one after the last: table size
+    uint16_t mapIdx[4];    // DTZ: start of the map of each WDL result
+};
+
+/**
+ * One mapped table. Kept sorted by (kind, name) so lookups are a binary search
+ */
+struct tb_entry {
+    char name[TB_NAME_LENGTH];
+    enum tbKind kind;
+    const unsigned char *data;
+    size_t size;
+    int pieceCount;
+    bool hasPawns;
+    bool hasUniquePieces;  // A side has exactly one of some piece other than the king
+    bool symmetric;        // Both sides have the same pieces, so only white to move is stored
+    int pawnCount[2];      // Pawns of the leading colour (the side with fewer, but some, pawns), then the other's
+    int sides;             // Sides to move stored: 2 for WDL tables that are not symmetric
+    const unsigned char *dtzMap;
+    struct tb_pairs *pairs;  // [side * TB_MAX_FILES + file]
+};
+
+static struct tb_entry *tables = NULL;
+static int numTables = 0;
+static int largest = 0;
+
+static const char *extensions[numTBKinds] = {".rtbw", ".rtbz"};
+static const unsigned char magic[numTBKinds][4] = {
+    {0x71, 0xE8, 0x23, 0x5D},  // WDL
+    {0xD7, 0x66, 0x0C, 0xA5},  // DTZ
+};
+
+// Index encoding tables, filled by _init_indices
+static bool indices_ready = false;
+static int map_pawns[totalSquares];      // a2-h7 to 0..47; the leading pawn has the highest value
+static int map_b1h1h7[totalSquares];     // Squares below the a1-h8 diagonal to 0..27
+static int map_a1d1d4[totalSquares];     // The a1-d1-d4 triangle to 0..9, diagonal last
+static int map_kk[10][totalSquares];     // The 462 legal placements of two kings, the first in a1-d1-d4
+static uint64_t binomial[6][totalSquares];        // [k][n]: ways to choose k of n
+static uint64_t lead_pawn_idx[6][totalSquares];   // [leading pawns][square of the first]
+static uint64_t lead_pawns_size[6][TB_MAX_FILES];  // [leading pawns][file]
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Little / big endian reads: tables are byte streams, whatever the host
+ */
+static uint32_t _le16(const unsigned char *p) {
+    return (uint32_t) p[0] | (uint32_t) p[1] << 8;
+}
+
+static uint32_t _le32(const unsigned char *p) {
+    return _le16(p) | _le16(p + 2) << 16;
+}
+
+static uint32_t _be32(const unsigned char *p) {
+    return (uint32_t) p[0] << 24 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 8 | (uint32_t) p[3];
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * @return How far sq is above the a1-h8 diagonal (negative below it)
+ */
+static int _off_diagonal(int sq) {
+    return (sq >> 3) - (sq & 7);
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Fills the index encoding tables
+ */
+static void _init_indices(void) {
+    if (indices_ready) return;
+    int code = 0;
+    for (int sq = a1; sq <= h8; sq++) {
+        if (_off_diagonal(sq) < 0) map_b1h1h7[sq] = code++;
+    }
+
+    int diagonal[4], numDiagonal = 0;
+    code = 0;
+    for (int sq = a1; sq <= d4; sq++) {
+        if ((sq & 7) > 3) continue;
+        if (_off_diagonal(sq) < 0) map_a1d1d4[sq] = code++;
+        else if (_off_diagonal(sq) == 0) diagonal[numDiagonal++] = sq;
+    }
+    for (int i = 0; i < numDiagonal; i++) map_a1d1d4[diagonal[i]] = code++;
+
+    // If the first king is on the diagonal, the second may not be above it. Both on the diagonal come last
+    int bothOnDiagonal[64][2], numBoth = 0;
+    code = 0;
+    for (int idx = 0; idx < 10; idx++) {
+        for (int s1 = a1; s1 <= d4; s1++) {
+            if (map_a1d1d4[s1] != idx || (idx == 0 && s1 != b1)) continue;  // b1 is the only square mapped to 0
+            for (int s2 = a1; s2 <= h8; s2++) {
+                int fileDistance = abs((s1 & 7) - (s2 & 7)), rankDistance = abs((s1 >> 3) - (s2 >> 3));
+                if (fileDistance <= 1 && rankDistance <= 1) continue;  // Touching kings
+                if (_off_diagonal(s1) == 0 && _off_diagonal(s2) > 0) continue;
+                if (_off_diagonal(s1) == 0 && _off_diagonal(s2) == 0) {
+                    bothOnDiagonal[numBoth][0] = idx;
+                    bothOnDiagonal[numBoth++][1] = s2;
+                }
+                else map_kk[idx][s2] = code++;
+            }
+        }
+    }
+    for (int i = 0; i < numBoth; i++) map_kk[bothOnDiagonal[i][0]][bothOnDiagonal[i][1]] = code++;
+
+    binomial[0][0] = 1;
+    for (int n = 1; n < totalSquares; n++) {
+        for (int k = 0; k < 6 && k <= n; k++) {
+            binomial[k][n] = (k > 0 ? binomial[k - 1][n - 1] : 0) + (k < n ? binomial[k][n - 1] : 0);
+        }
+    }
+
+    // Leading pawns: the one nearest the edge, then lowest, is first; the rest cannot be further out or lower
+    int available = 47;
+    for (int leadPawns = 1; leadPawns <= 5; leadPawns++) {
+        for (int file = 0; file < TB_MAX_FILES; file++) {
+            uint64_t idx = 0;
+            for (int rank = 1; rank <= 6; rank++) {
+                int sq = rank * 8 + file;
+                if (leadPawns == 1) {
+                    map_pawns[sq] = available--;
+                    map_pawns[sq ^ 7] = available--;
+                }
+                lead_pawn_idx[leadPawns][sq] = idx;
+                idx += binomial[leadPawns - 1][map_pawns[sq]];
+            }
+            lead_pawns_size[leadPawns][file] = idx;
+        }
+    }
+    indices_ready = true;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * @return Pieces per type ("PNBRQK" order) of one side of a table name, or false if it is not one
+ */
+static bool _count_side(const char *side, int length, int *counts) {
+    const char *letters = "PNBRQK";
+    memset(counts, 0, whiteAll * sizeof(int));
+    if (length < 1 || side[0] != 'K') return false;
+    for (int i = 0; i < length; i++) {
+        const char *letter = memchr(letters, side[i], whiteAll);
+        if (letter == NULL) return false;
+        counts[letter - letters]++;
+    }
+    return counts[whiteKing] == 1;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Sets the material fields of an entry from its name (ie. "KRPvKR")
+ * @return Whether the name is a valid table name of at most TB_MAX_PIECES pieces
+ */
+static bool _set_material(struct tb_entry *e) {
+    const char *v = strchr(e->name, 'v');
+    if (v == NULL) return false;
+    int counts[2][whiteAll];
+    if (!_count_side(e->name, (int) (v - e->name), counts[0]) || !_count_side(v + 1, (int) strlen(v + 1), counts[1])) {
+        return false;
+    }
+    e->pieceCount = (int) strlen(e->name) - 1;
+    if (e->pieceCount > TB_MAX_PIECES) return false;
+    size_t strongLength = v - e->name;
+    e->symmetric = strlen(v + 1) == strongLength && strncmp(e->name, v + 1, strongLength) == 0;
+    e->hasPawns = counts[0][whitePawns] || counts[1][whitePawns];
+    e->hasUniquePieces = false;
+    for (int c = 0; c < 2; c++) {
+        for (int type = whitePawns; type < whiteKing; type++) {
+            if (counts[c][type] == 1) e->hasUniquePieces = true;
+        }
+    }
+    bool whiteLeads = !counts[1][whitePawns]
+                      || (counts[0][whitePawns] && counts[1][whitePawns] >= counts[0][whitePawns]);
+    e->pawnCount[0] = counts[whiteLeads ? 0 : 1][whitePawns];
+    e->pawnCount[1] = counts[whiteLeads ? 1 : 0][whitePawns];
+    return true;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Splits d->pieces into groups, and computes each group's index multiplier
+ * @param order Encoding position of the leading group and of the remaining pawns (0xF: none)
+ */
+static void _set_groups(const struct tb_entry *e, struct tb_pairs *d, const int *order, int file) {
+    int n = 0, firstLen = e->hasPawns ? 0 : e->hasUniquePieces ? 3 : 2;
+    d->groupLen[n] = 1;
+    for (int i = 1; i < e->pieceCount; i++) {
+        if (--firstLen > 0 || d->pieces[i] == d->pieces[i - 1]) d->groupLen[n]++;
+        else d->groupLen[++n] = 1;
+    }
+    d->groupLen[++n] = 0;
+
+    // Index: g1 * N(g2) * N(g3) + g2 * N(g3) + g3, with the groups taken in the table's order
+    bool pp = e->hasPawns && e->pawnCount[1];
+    int next = pp ? 2 : 1;
+    int freeSquares = 64 - d->groupLen[0] - (pp ? d->groupLen[1] : 0);
+    uint64_t idx = 1;
+    for (int k = 0; next < n || k == order[0] || k == order[1]; k++) {
+        if (k == order[0]) {
+            d->groupIdx[0] = idx;
+            idx *= e->hasPawns ? lead_pawns_size[d->groupLen[0]][file] : e->hasUniquePieces ? 31332 : 462;
+        }
+        else if (k == order[1]) {
+            d->groupIdx[1] = idx;
+            idx *= binomial[d->groupLen[1]][48 - d->groupLen[0]];
+        }
+        else {
+            d->groupIdx[next] = idx;
+            idx *= binomial[d->groupLen[next]][freeSquares];
+            freeSquares -= d->groupLen[next++];
+        }
+    }
+    d->groupIdx[n] = idx;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Computes how many values each symbol expands to. The tree is acyclic in a valid table
+ * @return false if a symbol refers to one that does not exist
+ */
+static bool _set_symlen(struct tb_pairs *d, int sym, bool *visited) {
+    visited[sym] = true;
+    const unsigned char *lr = d->btree + 3 * sym;
+    int right = lr[2] << 4 | lr[1] >> 4;
+    if (right == 0xFFF) {
+        d->symlen[sym] = 0;
+        return true;
+    }
+    int left = (lr[1] & 0xF) << 8 | lr[0];
+    if (left >= d->numSyms || right >= d->numSyms) return false;
+    if (!visited[left] && !_set_symlen(d, left, visited)) return false;
+    if (!visited[right] && !_set_symlen(d, right, visited)) return false;
+    d->symlen[sym] = (uint8_t) (d->symlen[left] + d->symlen[right] + 1);
+    return true;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Reads a sub-table's compression header
+ * @return Position after it, or NULL if it is malformed
+ */
+static const unsigned char *_set_sizes(struct tb_pairs *d, const unsigned char *p, const unsigned char *end) {
+    if (end - p < 2) return NULL;
+    d->flags = *p++;
+    if (d->flags & tbSingleValue) {
+        d->minSymLen = *p++;
+        return p;
+    }
+
+    if (end - p < 9 || p[0] < 3 || p[0] > 30 || p[1] > 30) return NULL;
+    int n = 0;
+    while (d->groupLen[n]) n++;
+    d->blockSize = (size_t) 1 << p[0];
+    d->span = (size_t) 1 << p[1];
+    d->sparseIndexSize = (size_t) ((d->groupIdx[n] + d->span - 1) / d->span);
+    int padding = p[2];
+    d->numBlocks = _le32(p + 3);
+    d->blockLengthSize = d->numBlocks + padding;
+    d->maxSymLen = p[7];
+    d->minSymLen = p[8];
+    p += 9;
+    if (d->minSymLen < 1 || d->maxSymLen < d->minSymLen || d->maxSymLen > 32) return NULL;
+
+    // Canonical Huffman code: longer codes have lower values, so base64[] decreases with the length
+    int lengths = d->maxSymLen - d->minSymLen + 1;
+    if (end - p < 2 * lengths + 2) return NULL;
+    d->lowestSym = p;
+    d->base64 = xcalloc(lengths, sizeof(uint64_t));
+    for (int i = lengths - 2; i >= 0; i--) {
+        d->base64[i] = (d->base64[i + 1] + _le16(p + 2 * i) - _le16(p + 2 * (i + 1))) / 2;
+    }
+    for (int i = 0; i < lengths; i++) d->base64[i] <<= 64 - i - d->minSymLen;
+    p += 2 * lengths;
+
+    d->numSyms = (int) _le16(p);
+    p += 2;
+    if (d->numSyms > TB_MAX_SYMBOLS || end - p < 3 * d->numSyms + 1) return NULL;
+    d->btree = p;
+    d->symlen = xcalloc(d->numSyms + 1, sizeof(uint8_t));
+    bool visited[TB_MAX_SYMBOLS] = {false};
+    for (int sym = 0; sym < d->numSyms; sym++) {
+        if (!visited[sym] && !_set_symlen(d, sym, visited)) return NULL;
+    }
+    return p + 3 * d->numSyms + (d->numSyms & 1);
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Reads the DTZ value maps, which follow the compression headers
+ * @return Position after them, or NULL if they run past the end
+ */
+static const unsigned char *_set_dtz_map(struct tb_entry *e, const unsigned char *p, const unsigned char *end,
+                                         int files) {
+    e->dtzMap = p;
+    for (int f = 0; f < files; f++) {
+        struct tb_pairs *d = &e->pairs[f];
+        if (!(d->flags & tbMapped)) continue;
+        if (d->flags & tbWide) {
+            p += (p - e->data) & 1;
+            for (int i = 0; i < 4; i++) {
+                if (end - p < 2) return NULL;
+                d->mapIdx[i] = (uint16_t) ((p - e->dtzMap) / 2 + 1);
+                p += 2 * _le16(p) + 2;
+            }
+        }
+        else {
+            for (int i = 0; i < 4; i++) {
+                if (end - p < 1) return NULL;
+                d->mapIdx[i] = (uint16_t) (p - e->dtzMap + 1);
+                p += *p + 1;
+            }
+        }
+    }
+    if (p > end) return NULL;
+    return p + ((p - e->data) & 1);
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Reads a table's headers: piece order, groups, and where each sub-table's index and blocks are
+ * @return Whether the table is well formed and matches its name
+ */
+static bool _parse_table(struct tb_entry *e) {
+    const unsigned char *p = e->data + 4, *end = e->data + e->size;
+    if (end - p < 1) return false;
+    bool split = *p & 1, pawns = (*p & 2) != 0;
+    if (split == e->symmetric || pawns != e->hasPawns) return false;
+    p++;
+
+    e->sides = (e->kind == tbWDL && !e->symmetric) ? 2 : 1;
+    int files = e->hasPawns ? TB_MAX_FILES : 1;
+    e->pairs = xcalloc(2 * TB_MAX_FILES, sizeof(struct tb_pairs));
+    bool pp = e->hasPawns && e->pawnCount[1];
+    for (int f = 0; f < files; f++) {
+        if (end - p < 1 + pp + e->pieceCount) return false;
+        int order[2][2] = {{p[0] & 0xF, pp ? p[1] & 0xF : 0xF}, {p[0] >> 4, pp ? p[1] >> 4 : 0xF}};
+        p += 1 + pp;
+        for (int k = 0; k < e->pieceCount; k++, p++) {
+            for (int i = 0; i < e->sides; i++) {
+                int piece = i ? *p >> 4 : *p & 0xF;
+                if ((piece & 7) < 1 || (piece & 7) > 6) return false;
+                e->pairs[i * TB_MAX_FILES + f].pieces[k] = piece;
+            }
+        }
+        for (int i = 0; i < e->sides; i++) _set_groups(e, &e->pairs[i * TB_MAX_FILES + f], order[i], f);
+    }
+    p += (p - e->data) & 1;
+
+    for (int f = 0; f < files; f++) {
+        for (int i = 0; i < e->sides; i++) {
+            if ((p = _set_sizes(&e->pairs[i * TB_MAX_FILES + f], p, end)) == NULL) return false;
+        }
+    }
+    if (e->kind == tbDTZ && (p = _set_dtz_map(e, p, end, files)) == NULL) return false;
+
+    for (int f = 0; f < files; f++) {
+        for (int i = 0; i < e->sides; i++) {
+            struct tb_pairs *d = &e->pairs[i * TB_MAX_FILES + f];
+            d->sparseIndex = p;
+            if ((size_t) (end - p) < 6 * d->sparseIndexSize) return false;
+            p += 6 * d->sparseIndexSize;
+        }
+    }
+    for (int f = 0; f < files; f++) {
+        for (int i = 0; i < e->sides; i++) {
+            struct tb_pairs *d = &e->pairs[i * TB_MAX_FILES + f];
+            d->blockLength = p;
+            if ((size_t) (end - p) < 2 * (size_t) d->blockLengthSize) return false;
+            p += 2 * (size_t) d->blockLengthSize;
+        }
+    }
+    for (int f = 0; f < files; f++) {
+        for (int i = 0; i < e->sides; i++) {
+            struct tb_pairs *d = &e->pairs[i * TB_MAX_FILES + f];
+            p += (64 - ((p - e->data) & 63)) & 63;  // Blocks start on 64 byte boundaries
+            d->data = p;
+            d->end = end;
+            if (p > end || (size_t) (end - p) < d->numBlocks * d->blockSize) return false;
+            p += d->numBlocks * d->blockSize;
+        }
+    }
+    return true;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Frees what _parse_table allocated
+ */
+static void _free_pairs(struct tb_entry *e) {
+    if (e->pairs == NULL) return;
+    for (int i = 0; i < 2 * TB_MAX_FILES; i++) {
+        free(e->pairs[i].base64);
+        free(e->pairs[i].symlen);
+    }
+    free(e->pairs);
+    e->pairs = NULL;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * @return Value stored for position idx of a sub-table, or -1 if the table is broken
+ */
+static int _decompress(const struct tb_pairs *d, uint64_t idx) {
+    if (d->flags & tbSingleValue) return d->minSymLen;
+
+    // The sparse index points near idx; walk the block lengths the rest of the way
+    uint64_t k = idx / d->span;
+    if (k >= d->sparseIndexSize) return -1;
+    uint32_t block = _le32(d->sparseIndex + 6 * k);
+    int64_t offset = (int64_t) _le16(d->sparseIndex + 6 * k + 4) + (int64_t) (idx % d->span) - (int64_t) (d->span / 2);
+    while (offset < 0) {
+        if (block == 0) return -1;
+        offset += _le16(d->blockLength + 2 * --block) + 1;
+    }
+    while (block < d->blockLengthSize && offset > _le16(d->blockLength + 2 * block)) {
+        offset -= _le16(d->blockLength + 2 * block++) + 1;
+    }
+    if (block >= d->numBlocks) return -1;
+
+    // Decode symbols until the one that covers offset
+    const unsigned char *p = d->data + (uint64_t) block * d->blockSize;
+    uint64_t buf64 = (uint64_t) _be32(p) << 32 | _be32(p + 4);
+    p += 8;
+    int buf64Size = 64;
+    int lengths = d->maxSymLen - d->minSymLen + 1;
+    int sym;
+    for (;;) {
+        int len = 0;
+        while (len < lengths - 1 && buf64 < d->base64[len]) len++;
+        sym = (int) ((buf64 - d->base64[len]) >> (64 - len - d->minSymLen)) + (int) _le16(d->lowestSym + 2 * len);
+        if (sym >= d->numSyms) return -1;
+        if (offset < d->symlen[sym] + 1) break;
+        offset -= d->symlen[sym] + 1;
+        len += d->minSymLen;
+        buf64 <<= len;
+        buf64Size -= len;
+        if (buf64Size <= 32) {
+            buf64Size += 32;
+            if (d->end - p >= 4) buf64 |= (uint64_t) _be32(p) << (64 - buf64Size);
+            p += 4;
+        }
+    }
+
+    // Then expand it down to the single value at offset
+    for (int steps = 0; d->symlen[sym]; steps++) {
+        if (steps >= d->numSyms) return -1;
+        const unsigned char *lr = d->btree + 3 * sym;
+        int left = (lr[1] & 0xF) << 8 | lr[0];
+        if (offset < d->symlen[left] + 1) sym = left;
+        else {
+            offset -= d->symlen[left] + 1;
+            sym = lr[2] << 4 | lr[1] >> 4;
+        }
+    }
+    const unsigned char *lr = d->btree + 3 * sym;
+    return (lr[1] & 0xF) << 8 | lr[0];
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Maps path if it is a Syzygy table with a valid header, and appends it to tables
+ */
+static void _add_table(const char *path, const char *name, enum tbKind kind, int *capacity) {
+    struct tb_entry entry = {0};
+    strcpy(entry.name, name);
+    entry.kind = kind;
+    if (!_set_material(&entry)) return;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < 4) {
+        close(fd);
+        return;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return;
+    entry.data = map;
+    entry.size = st.st_size;
+    if (memcmp(map, magic[kind], 4) != 0 || !_parse_table(&entry)) {
+        _free_pairs(&entry);
+        munmap(map, st.st_size);
+        return;
+    }
+
+    if (numTables == *capacity) {
+        *capacity = *capacity ? 2 * *capacity : 64;
+        struct tb_entry *grown = xcalloc(*capacity, sizeof(struct tb_entry));
+        if (numTables) memcpy(grown, tables, numTables * sizeof(struct tb_entry));
+        free(tables);
+        tables = grown;
+    }
+    tables[numTables++] = entry;
+    if (kind == tbWDL && entry.pieceCount > largest) largest = entry.pieceCount;
+}
+
+
+static int _compare_entries(const void *a, const void *b) {
+    const struct tb_entry *x = a, *y = b;
+    if (x->kind != y->kind) return (int) x->kind - (int) y->kind;
+    return strcmp(x->name, y->name);
+}
+
+
+int tb_init(const char *path) {
+    REQUIRES(path != NULL);
+    tb_free();
+    _init_indices();
+    int capacity = 0;
+
+    // Walk each ':' separated directory
+    const char *dir_start = path;
+    while (*dir_start) {
+        size_t dir_length = strcspn(dir_start, ":");
+        char dir_path[1024];
+        if (dir_length > 0 && dir_length < sizeof(dir_path)) {
+            memcpy(dir_path, dir_start, dir_length);
+            dir_path[dir_length] = '\0';
+
+            DIR *dir = opendir(dir_path);
+            struct dirent *file;
+            while (dir != NULL && (file = readdir(dir)) != NULL) {
+                // Table names look like KRPvKR.rtbw
+                const char *dot = strrchr(file->d_name, '.');
+                size_t name_length = dot ? (size_t) (dot - file->d_name) : 0;
+                if (name_length < 3 || name_length >= TB_NAME_LENGTH) continue;
+                for (enum tbKind kind = tbWDL; kind < numTBKinds; kind++) {
+                    if (strcmp(dot, extensions[kind]) != 0) continue;
+                    char name[TB_NAME_LENGTH];
+                    memcpy(name, file->d_name, name_length);
+                    name[name_length] = '\0';
+                    char file_path[2048];
+                    snprintf(file_path, sizeof(file_path), "%s/%s", dir_path, file->d_name);
+                    _add_table(file_path, name, kind, &capacity);
+                }
+            }
+            if (dir != NULL) closedir(dir);
+        }
+        dir_start += dir_length;
+        if (*dir_start == ':') dir_start++;
+    }
+
+    qsort(tables, numTables, sizeof(struct tb_entry), _compare_entries);
+    return numTables;
+}
+
+
+void tb_free(void) {
+    for (int i = 0; i < numTables; i++) {
+        _free_pairs(&tables[i]);
+        munmap((void *) tables[i].data, tables[i].size);
+    }
+    free(tables);
+    tables = NULL;
+    numTables = 0;
+    largest = 0;
+}
+
+
+int tb_largest(void) {
+    return largest;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Writes one side's pieces in Syzygy order (ie. "KQRBNP"), and returns the new end of res
+ * @param color 0 for white, colorOffset for black
+ */
+static char *_side_name(FEN position, int color, char *res) {
+    const char *letters = "PNBRQK";
+    for (int type = whiteKing; type >= whitePawns; type--) {
+        for (int n = popCount(position->BBoard[color + type]); n > 0; n--) *res++ = letters[type];
+    }
+    return res;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Writes the Syzygy material name of position (ie. "KRPvKR"), with white's pieces first
+ * @param position At most TB_MAX_PIECES pieces
+ * @param res Buffer of TB_NAME_LENGTH chars
+ */
+static void _material_name(FEN position, char *res) {
+    REQUIRES(popCount(position->BBoard[whiteAll] | position->BBoard[blackAll]) <= TB_MAX_PIECES);
+    char *c = _side_name(position, 0, res);
+    *c++ = 'v';
+    c = _side_name(position, colorOffset, c);
+    *c = '\0';
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Finds the table for position's material, in either colour orientation
+ * @param swapped Set to whether the table has black's pieces first (so colours must be flipped to probe it)
+ * @return The table, or NULL
+ */
+static const struct tb_entry *_find_table(FEN position, enum tbKind kind, bool *swapped) {
+    int pieces = popCount(position->BBoard[whiteAll] | position->BBoard[blackAll]);
+    if (pieces > largest || numTables == 0) return NULL;
+
+    struct tb_entry wanted;
+    wanted.kind = kind;
+    _material_name(position, wanted.name);
+    for (int attempt = 0; attempt < 2; attempt++) {
+        const struct tb_entry *found = bsearch(&wanted, tables, numTables, sizeof(struct tb_entry), _compare_entries);
+        if (found != NULL) {
+            *swapped = attempt == 1;
+            return found;
+        }
+        char *v = strchr(wanted.name, 'v');
+        char swappedName[TB_NAME_LENGTH];
+        snprintf(swappedName, sizeof(swappedName), "%sv%.*s", v + 1, (int) (v - wanted.name), wanted.name);
+        strcpy(wanted.name, swappedName);
+    }
+    return NULL;
+}
+
+
+const unsigned char *tb_table(FEN position, enum tbKind kind, size_t *size) {
+    REQUIRES(position != NULL && size != NULL);
+    bool swapped;
+    const struct tb_entry *found = _find_table(position, kind, &swapped);
+    if (found == NULL) return NULL;
+    *size = found->size;
+    return found->data;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Stable insertion sort of squares, by key[square] (or by the square itself if key is NULL)
+ */
+static void _sort_squares(int *squares, int n, const int *key) {
+    for (int i = 1; i < n; i++) {
+        int sq = squares[i], j = i;
+        for (; j > 0 && (key ? key[squares[j - 1]] > key[sq] : squares[j - 1] > sq); j--) squares[j] = squares[j - 1];
+        squares[j] = sq;
+    }
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * @return Syzygy code of the piece on sq: 1-6 white pawn to king, 9-14 black
+ */
+static int _piece_code(FEN position, int sq) {
+    for (int type = whitePawns; type < numPieceTypes; type++) {
+        if (type == whiteAll || !(position->BBoard[type] >> sq & 1)) continue;
+        return type % colorOffset + 1 + (type / colorOffset) * 8;
+    }
+    return 0;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Probes a single table: position is encoded into the table's index and its value decompressed
+ * @param wdl For DTZ, the position's WDL result, which selects the value map
+ * @param state Set to tbFail or tbChangeSTM if the value is not usable, otherwise left alone
+ * @return WDL result (-2..2), or DTZ in plies (as stored, before sign and the 50-move rule)
+ */
+static int _probe_table(FEN position, enum tbKind kind, int wdl, enum tbState *state) {
+    uint64_t occupied = position->BBoard[whiteAll] | position->BBoard[blackAll];
+    if (popCount(occupied) == 2) return 0;  // KvK
+    bool swapped;
+    const struct tb_entry *e = _find_table(position, kind, &swapped);
+    if (e == NULL) {
+        *state = tbFail;
+        return 0;
+    }
+
+    // Tables have white as the side with more material, and symmetric ones only white to move: otherwise flip colours
+    int blackToMove = !position->whiteToMove;
+    int flip = (e->symmetric && blackToMove) || swapped;
+    int flipColor = flip ? 8 : 0, flipSquares = flip ? 56 : 0;
+    int stm = flip ^ blackToMove;
+    int squares[TB_MAX_PIECES], pieces[TB_MAX_PIECES];
+    int size = 0, leadPawnsCnt = 0, file = 0;
+    uint64_t leadPawns = 0;
+
+    // With pawns, the table is split by the file of the leading pawn: nearest the edge, then lowest
+    if (e->hasPawns) {
+        int pawn = e->pairs[0].pieces[0] ^ flipColor;
+        leadPawns = position->BBoard[(pawn & 8) ? blackPawns : whitePawns];
+        for (uint64_t b = leadPawns; b; b &= b - 1) squares[size++] = bitScanForward(b) ^ flipSquares;
+        leadPawnsCnt = size;
+        int lead = 0;
+        for (int i = 1; i < leadPawnsCnt; i++) {
+            if (map_pawns[squares[i]] > map_pawns[squares[lead]]) lead = i;
+        }
+        int tmp = squares[0];
+        squares[0] = squares[lead];
+        squares[lead] = tmp;
+        file = squares[0] & 7;
+        if (file > 3) file = 7 - file;
+    }
+
+    const struct tb_pairs *d = &e->pairs[(stm % e->sides) * TB_MAX_FILES + file];
+    if (kind == tbDTZ && (d->flags & tbSTM) != stm && !(e->symmetric && !e->hasPawns)) {
+        *state = tbChangeSTM;
+        return 0;
+    }
+
+    for (uint64_t b = occupied & ~leadPawns; b; b &= b - 1) {
+        int sq = bitScanForward(b);
+        squares[size] = sq ^ flipSquares;
+        pieces[size++] = _piece_code(position, sq) ^ flipColor;
+    }
+
+    // Put the pieces in the table's order
+    for (int i = leadPawnsCnt; i < size - 1; i++) {
+        for (int j = i + 1; j < size; j++) {
+            if (d->pieces[i] != pieces[j]) continue;
+            int tmp = pieces[i];
+            pieces[i] = pieces[j];
+            pieces[j] = tmp;
+            tmp = squares[i];
+            squares[i] = squares[j];
+            squares[j] = tmp;
+            break;
+        }
+    }
+
+    // Mirror so the first piece is on files a-d
+    if ((squares[0] & 7) > 3) {
+        for (int i = 0; i < size; i++) squares[i] ^= 7;
+    }
+
+    uint64_t idx;
+    if (e->hasPawns) {
+        idx = lead_pawn_idx[leadPawnsCnt][squares[0]];
+        _sort_squares(squares + 1, leadPawnsCnt - 1, map_pawns);
+        for (int i = 1; i < leadPawnsCnt; i++) idx += binomial[i][map_pawns[squares[i]]];
+    }
+    else {
+        // Without pawns, also mirror onto ranks 1-4, then below the a1-h8 diagonal
+        if ((squares[0] >> 3) > 3) {
+            for (int i = 0; i < size; i++) squares[i] ^= 56;
+        }
+        for (int i = 0; i < d->groupLen[0]; i++) {
+            if (!_off_diagonal(squares[i])) continue;
+            if (_off_diagonal(squares[i]) > 0) {
+                for (int j = i; j < size; j++) squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+            }
+            break;
+        }
+
+        // Three unique pieces (kings included) are encoded together, otherwise just the kings
+        if (e->hasUniquePieces) {
+            int adjust1 = squares[1] > squares[0];
+            int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+            if (_off_diagonal(squares[0])) {
+                idx = ((uint64_t) map_a1d1d4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+            }
+            else if (_off_diagonal(squares[1])) {
+                idx = (6 * 63 + (squares[0] >> 3) * 28 + map_b1h1h7[squares[1]]) * 62 + squares[2] - adjust2;
+            }
+            else if (_off_diagonal(squares[2])) {
+                idx = 6 * 63 * 62 + 4 * 28 * 62 + (squares[0] >> 3) * 7 * 28 + ((squares[1] >> 3) - adjust1) * 28
+                      + map_b1h1h7[squares[2]];
+            }
+            else {
+                idx = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + (squares[0] >> 3) * 7 * 6
+                      + ((squares[1] >> 3) - adjust1) * 6 + ((squares[2] >> 3) - adjust2);
+            }
+        }
+        else idx = map_kk[map_a1d1d4[squares[0]]][squares[1]];
+    }
+
+    // Remaining groups, each as a combination of the squares left by the groups before it
+    idx *= d->groupIdx[0];
+    int *groupSq = squares + d->groupLen[0];
+    bool remainingPawns = e->hasPawns && e->pawnCount[1];
+    for (int next = 1; d->groupLen[next]; next++) {
+        _sort_squares(groupSq, d->groupLen[next], NULL);
+        uint64_t n = 0;
+        for (int i = 0; i < d->groupLen[next]; i++) {
+            int adjust = 0;
+            for (int *s = squares; s < groupSq; s++) adjust += groupSq[i] > *s;
+            int rest = groupSq[i] - adjust - 8 * remainingPawns;  // Square among those still free
+            if (rest < 0) {
+                *state = tbFail;
+                return 0;
+            }
+            n += binomial[i + 1][rest];
+        }
+        remainingPawns = false;
+        idx += n * d->groupIdx[next];
+        groupSq += d->groupLen[next];
+    }
+
+    int value = _decompress(d, idx);
+    if (value < 0) {
+        *state = tbFail;
+        return 0;
+    }
+    if (kind == tbWDL) return value - 2;
+
+    // DTZ: map the stored value, and convert moves to plies
+    static const int wdl_map[] = {1, 3, 0, 2, 0};
+    if (d->flags & tbMapped) {
+        size_t at = d->mapIdx[wdl_map[wdl + 2]] + (size_t) value;
+        size_t mapSize = e->data + e->size - e->dtzMap;
+        bool wide = d->flags & tbWide;
+        if (mapSize < (wide ? 2 * at + 2 : at + 1)) {
+            *state = tbFail;
+            return 0;
+        }
+        value = wide ? (int) _le16(e->dtzMap + 2 * at) : e->dtzMap[at];
+    }
+    if ((wdl == tbWin && !(d->flags & tbWinPlies)) || (wdl == tbLoss && !(d->flags & tbLossPlies))
+        || wdl == tbCursedWin || wdl == tbBlessedLoss) {
+        value *= 2;
+    }
+    return value + 1;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Tables know nothing of en passant, and may hold any value where a capture is best, so captures
+ * (and with zeroing, pawn moves) are searched before the table is trusted
+ * @param zeroing Also search pawn moves, as DTZ needs
+ * @param state Set to tbZeroingBest if a capture (or pawn move) is at least as good as the table's value
+ * @return WDL result, from the side to move's perspective
+ */
+static int _search_wdl(FEN position, bool zeroing, enum tbState *state) {
+    struct move_info moves[MAX_MOVES];
+    int n = generate_moves(position, moves);
+    int best = tbLoss, moveCount = 0;
+    for (int i = 0; i < n; i++) {
+        bool capture = captured_piece(position, &moves[i]) != numPieceTypes;
+        if (!capture && (!zeroing || moves[i].piece % colorOffset != whitePawns)) continue;
+        moveCount++;
+        struct FEN_info after = *position;
+        play_move(&after, &moves[i]);
+        int value = -_search_wdl(&after, false, state);
+        if (*state == tbFail) return tbDraw;
+        if (value > best) {
+            best = value;
+            if (value >= tbWin) {
+                *state = tbZeroingBest;
+                return value;
+            }
+        }
+    }
+
+    // Every legal move searched: the table may be wrong (ie. it ignores en passant), so do not probe it
+    bool noMoreMoves = moveCount && moveCount == n;
+    int value = best;
+    if (!noMoreMoves) {
+        value = _probe_table(position, tbWDL, 0, state);
+        if (*state == tbFail) return tbDraw;
+    }
+    if (best >= value) {
+        *state = (best > tbDraw || noMoreMoves) ? tbZeroingBest : tbOK;
+        return best;
+    }
+    *state = tbOK;
+    return value;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * @return DTZ of a position whose best move zeroes the 50-move counter
+ */
+static int _dtz_before_zeroing(int wdl) {
+    return wdl == tbWin ? 1 : wdl == tbCursedWin ? 101 : wdl == tbBlessedLoss ? -101 : wdl == tbLoss ? -1 : 0;
+}
+
+
+static int _sign(int x) {
+    return (x > 0) - (x < 0);
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * @return Whether position is one the tables could cover
+ */
+static bool _probeable(FEN position) {
+#if VARIANT == VARIANT_STANDARD || VARIANT == VARIANT_CHESS960
+    return largest > 0 && !position->castling && !position->crazyhouse
+           && popCount(position->BBoard[whiteAll] | position->BBoard[blackAll]) <= largest;
+#else
+    (void) position;
+    return false;  // Other variants' rules change the results
+#endif
+}
+
+
+bool tb_probe_wdl(FEN position, int *wdl) {
+    REQUIRES(position != NULL && wdl != NULL);
+    if (!_probeable(position)) return false;
+    enum tbState state = tbOK;
+    int value = _search_wdl(position, false, &state);
+    if (state == tbFail) return false;
+    *wdl = value;
+    return true;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * @return DTZ as by tb_probe_dtz, or 0 with state tbFail
+ */
+static int _probe_dtz(FEN position, enum tbState *state) {
+    *state = tbOK;
+    int wdl = _search_wdl(position, true, state);
+    if (*state == tbFail || wdl == tbDraw) return 0;  // DTZ tables do not store draws
+    if (*state == tbZeroingBest) return _dtz_before_zeroing(wdl);
+
+    int dtz = _probe_table(position, tbDTZ, wdl, state);
+    if (*state == tbFail) return 0;
+    if (*state != tbChangeSTM) return (dtz + 100 * (wdl == tbBlessedLoss || wdl == tbCursedWin)) * _sign(wdl);
+
+    // The table stores the other side to move: take the best reply's DTZ, one ply further
+    struct move_info moves[MAX_MOVES], replies[MAX_MOVES];
+    int n = generate_moves(position, moves);
+    int minDTZ = 0xFFFF;
+    for (int i = 0; i < n; i++) {
+        bool zeroing = moves[i].piece % colorOffset == whitePawns
+                       || captured_piece(position, &moves[i]) != numPieceTypes;
+        struct FEN_info after = *position;
+        play_move(&after, &moves[i]);
+        // A zeroing move's DTZ is counted before it: the sign from the position after is all that is needed
+        dtz = zeroing ? -_dtz_before_zeroing(_search_wdl(&after, false, state)) : -_probe_dtz(&after, state);
+        if (*state == tbFail) return 0;
+        if (dtz == 1 && in_check(&after) && generate_moves(&after, replies) == 0) minDTZ = 1;  // Mate
+        if (!zeroing) dtz += _sign(dtz);
+        if (dtz < minDTZ && _sign(dtz) == _sign(wdl)) minDTZ = dtz;
+    }
+    return minDTZ == 0xFFFF ? -1 : minDTZ;  // No legal moves: mated
+}
+
+
+bool tb_probe_dtz(FEN position, int *dtz) {
+    REQUIRES(position != NULL && dtz != NULL);
+    if (!_probeable(position)) return false;
+    enum tbState state;
+    int value = _probe_dtz(position, &state);
+    if (state == tbFail) return false;
+    *dtz = value;
+    return true;
+}
+
+
+bool tb_rank_root_moves(FEN position, const struct move_info *moves, int n, int *ranks) {
+    REQUIRES(position != NULL && moves != NULL && n >= 0 && ranks != NULL);
+    if (!_probeable(position)) return false;
+    int cnt50 = position->halfMove;
+    for (int i = 0; i < n; i++) {
+        struct FEN_info after = *position;
+        play_move(&after, (move) &moves[i]);
+        enum tbState state = tbOK;
+        int dtz;
+        if (after.halfMove == 0) dtz = _dtz_before_zeroing(-_search_wdl(&after, false, &state));
+        else {
+            dtz = -_probe_dtz(&after, &state);
+            dtz += _sign(dtz);
+        }
+        if (state == tbFail) return false;
+        struct move_info replies[MAX_MOVES];
+        if (dtz == 2 && in_check(&after) && generate_moves(&after, replies) == 0) dtz = 1;  // Mates right away
+
+        // Wins the 50-move rule allows rank equally, as do losses it does not save; others by how close they come
+        if (dtz > 0) ranks[i] = (dtz + cnt50 <= 99) ? TB_RANK_WIN : TB_RANK_WIN - (dtz + cnt50);
+        else if (dtz < 0) ranks[i] = (-dtz * 2 + cnt50 < 100) ? -TB_RANK_WIN : -TB_RANK_WIN + (-dtz + cnt50);
+        else ranks[i] = 0;
+    }
+    return true;
+}
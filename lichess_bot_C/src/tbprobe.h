@@ -0,0 +1,93 @@
+//
+// Syzygy tablebases: discovery, read-only memory maps shared by every search thread, and WDL / DTZ probes.
+//
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef CHESS_TBPROBE_H
+#define CHESS_TBPROBE_H
+
+#define TB_MAX_PIECES 7
+#define TB_RANK_WIN 1000  // tb_rank_root_moves rank of a win the 50-move rule cannot spoil
+
+/**
+ * Kinds of Syzygy table
+ */
+enum tbKind {
+    tbWDL=0,  // .rtbw – win / draw / loss, probed inside the search
+    tbDTZ=1,  // .rtbz – distance to zeroing move, probed at the root
+    numTBKinds=2
+};
+
+/**
+ * Game-theoretic results. Cursed wins and blessed losses are wins and losses the 50-move rule turns into draws
+ */
+enum tbWDL {
+    tbLoss=-2,
+    tbBlessedLoss=-1,
+    tbDraw=0,
+    tbCursedWin=1,
+    tbWin=2
+};
+
+/**
+ * Scans directories for Syzygy tables and memory-maps every valid one read-only. Exported for the Python
+ * (ctypes) side. Calling it again replaces the tables from a previous call; never call it during a search
+ * @param path Directories separated by ':' (as the UCI SyzygyPath option)
+ * @return Number of tables found
+ */
+int tb_init(const char *path);
+
+/**
+ * Unmaps every table
+ */
+void tb_free(void);
+
+/**
+ * @return Most pieces (kings included) of any WDL table found, or 0 if there are none.
+ * Positions with more pieces never need a probe
+ */
+int tb_largest(void);
+
+/**
+ * Finds the mapped table for position's material, in either colour orientation
+ * @param position
+ * @param kind tbWDL or tbDTZ
+ * @param size Set to the table's size in bytes, if a table is found
+ * @return Start of the mapped table, or NULL if no table covers position
+ */
+const unsigned char *tb_table(FEN position, enum tbKind kind, size_t *size);
+
+/**
+ * Win / draw / loss of a position, for the search. Captures are searched first, as the tables require.
+ * Only valid right after a capture or pawn move: the result ignores how far the 50-move count has run
+ * @param position Without castling rights, and at most tb_largest() pieces
+ * @param wdl Set to the result for the side to move (enum tbWDL)
+ * @return Whether the tables cover position
+ */
+bool tb_probe_wdl(FEN position, int *wdl);
+
+/**
+ * Distance to zeroing: plies until the winning side can capture or move a pawn, playing on correctly
+ * @param position As for tb_probe_wdl
+ * @param dtz Set to it, positive when the side to move wins, negative when it loses, 0 for draws.
+ * Beyond +-100 for cursed wins and blessed losses
+ * @return Whether the tables cover position
+ */
+bool tb_probe_dtz(FEN position, int *dtz);
+
+/**
+ * Ranks root moves by DTZ and the 50-move count: TB_RANK_WIN for sure wins, 0 for draws, -TB_RANK_WIN for sure
+ * losses, and in between for results the 50-move rule may still change. Searching only the best-ranked moves
+ * keeps a won position won
+ * @param position As for tb_probe_wdl
+ * @param moves Legal moves of position
+ * @param n Number of moves
+ * @param ranks Set to each move's rank
+ * @return Whether the tables cover every move
+ */
+bool tb_rank_root_moves(FEN position, const struct move_info *moves, int n, int *ranks);
+
+#endif //CHESS_TBPROBE_H
@@ -0,0 +1,150 @@
+//
+// Time management: how long to think about a move, given the clock.
+//
+
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include "lib/contracts.h"
+#include "timeman.h"
+
+#define MIN_STABILITY 0.5
+#define MAX_STABILITY 2.0
+
+static struct time_control pending_clock;
+static int64_t move_overhead = DEFAULT_MOVE_OVERHEAD;
+static bool ponder_next;
+static atomic_bool ponderhit_requested;  // Set by other threads while a search runs
+static atomic_bool stop_requested;
+
+
+static uint64_t _now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000 + (uint64_t) ts.tv_nsec / 1000000;
+}
+
+
+void tm_set_clock(int64_t time, int64_t inc, int movesToGo) {
+    REQUIRES(time >= 0 && inc >= 0 && movesToGo >= 0);
+    pending_clock.time = time;
+    pending_clock.inc = inc;
+    pending_clock.movesToGo = movesToGo;
+}
+
+
+void tm_set_overhead(int64_t overhead) {
+    REQUIRES(overhead >= 0);
+    move_overhead = overhead;
+}
+
+
+void tm_init(timeman tm, struct time_control tc, int64_t overhead) {
+    REQUIRES(tm != NULL);
+    tm->start = _now_ms();
+    tm->stability = 1.0;
+    tm->stableIterations = 0;
+    tm->pondering = false;
+    tm->limited = tc.time > 0;
+    if (!tm->limited) {
+        tm->soft = tm->hard = INT64_MAX;
+        return;
+    }
+
+    int movesToGo = (tc.movesToGo > 0 && tc.movesToGo < DEFAULT_MOVES_TO_GO) ? tc.movesToGo : DEFAULT_MOVES_TO_GO;
+    int64_t available = tc.time - overhead;
+    if (available < 1) available = 1;
+
+    // Most of the increment comes back next move, so spend it now. Never plan on more than the clock has left
+    tm->soft = available / movesToGo + tc.inc * 3 / 4;
+    tm->hard = tm->soft * 4;
+    if (tm->hard > available * 3 / 4) tm->hard = available * 3 / 4;
+    if (movesToGo == 1) tm->hard = available * 9 / 10;  // Last move before the time control: use nearly all of it
+    if (tm->soft > tm->hard) tm->soft = tm->hard;
+    if (tm->hard < 1) tm->hard = tm->soft = 1;
+}
+
+
+void tm_ponder(bool on) {
+    ponder_next = on;
+    atomic_store(&ponderhit_requested, false);
+    atomic_store(&stop_requested, false);
+}
+
+
+void tm_ponderhit(void) {
+    atomic_store(&ponderhit_requested, true);
+}
+
+
+void tm_stop(void) {
+    atomic_store(&stop_requested, true);
+}
+
+
+void tm_start(timeman tm) {
+    REQUIRES(tm != NULL);
+    if (ponder_next) {
+        // Keep a stop / ponder hit that arrived before the search started. The clock comes with the ponder hit
+        ponder_next = false;
+        tm_init(tm, (struct time_control) {0}, 0);
+        tm->pondering = true;
+        return;
+    }
+    atomic_store(&stop_requested, false);
+    tm_init(tm, pending_clock, move_overhead);
+    pending_clock = (struct time_control) {0};
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Turns a ponder search into a timed one once tm_ponderhit is called. Time spent pondering is free
+ */
+static void _check_ponderhit(timeman tm) {
+    if (tm->pondering && atomic_exchange(&ponderhit_requested, false)) {
+        tm_init(tm, pending_clock, move_overhead);
+        pending_clock = (struct time_control) {0};
+    }
+}
+
+
+int64_t tm_elapsed(timeman tm) {
+    REQUIRES(tm != NULL);
+    return (int64_t) (_now_ms() - tm->start);
+}
+
+
+bool tm_iteration_done(timeman tm, bool bestMoveChanged) {
+    REQUIRES(tm != NULL);
+    _check_ponderhit(tm);
+    if (!tm->limited) return true;
+
+    // A changing best move means the position is unclear: think longer. A settled one is probably right
+    if (bestMoveChanged) {
+        tm->stableIterations = 0;
+        tm->stability *= 1.5;
+    } else {
+        tm->stableIterations++;
+        tm->stability *= (tm->stableIterations >= 3) ? 0.8 : 0.95;
+    }
+    if (tm->stability < MIN_STABILITY) tm->stability = MIN_STABILITY;
+    if (tm->stability > MAX_STABILITY) tm->stability = MAX_STABILITY;
+
+    // The next iteration usually takes longer than all earlier ones together, so only start it in the first half
+    int64_t soft = (int64_t) (tm->soft * tm->stability);
+    if (soft > tm->hard) soft = tm->hard;
+    return tm_elapsed(tm) < soft / 2;
+}
+
+
+bool tm_out_of_time(timeman tm) {
+    REQUIRES(tm != NULL);
+    if (atomic_load_explicit(&stop_requested, memory_order_relaxed)) return true;
+    _check_ponderhit(tm);
+    return tm->limited && tm_elapsed(tm) >= tm->hard;
+}
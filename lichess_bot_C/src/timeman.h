@@ -0,0 +1,107 @@
+//
+// Time management: how long to think about a move, given the clock.
+//
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef CHESS_TIMEMAN_H
+#define CHESS_TIMEMAN_H
+
+#define DEFAULT_MOVE_OVERHEAD 30  // ms lost per move outside the search (ctypes call, network). See tm_set_overhead
+#define DEFAULT_MOVES_TO_GO 40    // Assumed moves left in sudden death time controls
+
+/**
+ * Clock for the side to move, as sent by lichess (or a UCI "go" command). Times in milliseconds
+ */
+struct time_control {
+    int64_t time;    // Remaining time, or 0 for no clock (search to a fixed depth)
+    int64_t inc;     // Increment per move
+    int movesToGo;   // Moves until the next time control, or 0 for sudden death
+};
+
+/**
+ * Limits for one search. Both are measured from tm_start
+ *  - soft: don't start another iteration once past it (scaled by best move stability)
+ *  - hard: abort the search, even mid-iteration
+ */
+struct time_manager {
+    uint64_t start;      // Monotonic ms
+    int64_t soft;
+    int64_t hard;
+    double stability;    // Multiplier on soft: > 1 while the best move keeps changing, < 1 once it settles
+    int stableIterations;
+    bool limited;        // false when there is no clock
+    bool pondering;      // Searching on the opponent's time, unlimited until tm_ponderhit
+};
+typedef struct time_manager *timeman;
+
+/**
+ * Stores the clock for the next search. Exported for the Python (ctypes) side, which calls it before lichess()
+ * @param time Remaining time for the side to move, in ms
+ * @param inc Increment, in ms
+ * @param movesToGo 0 for sudden death
+ */
+void tm_set_clock(int64_t time, int64_t inc, int movesToGo);
+
+/**
+ * @param overhead ms to keep in reserve per move. Exported for the Python (ctypes) side
+ */
+void tm_set_overhead(int64_t overhead);
+
+/**
+ * Makes the next search a ponder search: it runs without limits until tm_ponderhit or tm_stop.
+ * Call before starting that search (not from inside it), so that an early ponder hit or stop is not lost
+ * @param on
+ */
+void tm_ponder(bool on);
+
+/**
+ * The opponent played the expected move. Safe to call from another thread while the ponder search runs:
+ * it becomes a normal timed search, with the clock from tm_set_clock (call that first) counted from now
+ */
+void tm_ponderhit(void);
+
+/**
+ * Stops the running search at its next tm_out_of_time check (ie. the opponent played an unexpected move).
+ * Safe to call from another thread
+ */
+void tm_stop(void);
+
+/**
+ * Starts the clock for a search, with limits from the clock given to tm_set_clock.
+ * The stored clock is used once: a later search without tm_set_clock is unlimited
+ * @param tm
+ */
+void tm_start(timeman tm);
+
+/**
+ * Computes limits without touching the stored clock
+ * @param tm
+ * @param tc
+ * @param overhead
+ */
+void tm_init(timeman tm, struct time_control tc, int64_t overhead);
+
+/**
+ * @param tm
+ * @return ms since tm_start
+ */
+int64_t tm_elapsed(timeman tm);
+
+/**
+ * Call after each completed iteration of iterative deepening. Always true while pondering
+ * @param tm
+ * @param bestMoveChanged Whether this iteration's best move differs from the previous iteration's
+ * @return Whether there is time to start another iteration
+ */
+bool tm_iteration_done(timeman tm, bool bestMoveChanged);
+
+/**
+ * Cheap enough to poll every few thousand nodes
+ * @param tm
+ * @return Whether the search must stop now (hard limit reached, or tm_stop called)
+ */
+bool tm_out_of_time(timeman tm);
+
+#endif //CHESS_TIMEMAN_H
@@ -0,0 +1,153 @@
+//
+// Transposition table: shared by all search threads, sized at runtime, backed by huge pages where possible.
+//
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <omp.h>
+
+#include "lib/contracts.h"
+#include "lib/large_alloc.h"
+#include "affinity.h"
+#include "tt.h"
+
+static struct tt_bucket *table;
+static size_t num_buckets;
+static size_t table_bytes;
+static bool use_huge_pages = true;
+static enum pageKind page_kind = pagesNormal;
+static uint8_t search_age;
+
+
+void tt_resize(size_t mb) {
+    REQUIRES(mb >= 1);
+    large_free(table, table_bytes);
+    table_bytes = mb << 20;
+    num_buckets = table_bytes / sizeof(struct tt_bucket);
+    table = large_alloc(table_bytes, use_huge_pages, &page_kind);
+    affinity_interleave(table, table_bytes);
+    tt_clear();  // large_alloc memory is zero already, but touching it in parallel spreads pages over NUMA nodes
+}
+
+
+void tt_init(void) {
+    if (table == NULL) tt_resize(TT_DEFAULT_MB);
+}
+
+
+void tt_set_huge_pages(bool on) {
+    use_huge_pages = on;
+}
+
+
+int tt_page_kind(void) {
+    return page_kind;
+}
+
+
+void tt_clear(void) {
+    if (table == NULL) return;
+    #pragma omp parallel
+    {
+        size_t threads = omp_get_num_threads();
+        size_t slice = (num_buckets + threads - 1) / threads;
+        size_t start = slice * omp_get_thread_num();
+        if (start < num_buckets) {
+            size_t count = (start + slice > num_buckets) ? num_buckets - start : slice;
+            memset(table + start, 0, count * sizeof(struct tt_bucket));
+        }
+    }
+    search_age = 0;
+}
+
+
+void tt_new_search(void) {
+    search_age++;
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Maps key onto [0, num_buckets) with a multiply instead of a modulo, so any table size works
+ */
+static struct tt_bucket *_bucket(uint64_t key) {
+    REQUIRES(table != NULL);
+    return &table[(size_t) (((unsigned __int128) key * num_buckets) >> 64)];
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * Reads an entry that other threads may be writing. Each word is read once, so the key is checked against the
+ * very data that is returned
+ * @param e
+ * @param res Receives the entry's data
+ * @return Key of the entry, or garbage if it is torn
+ */
+static uint64_t _load(const struct tt_entry *e, struct tt_data *res) {
+    uint64_t data = __atomic_load_n(&e->data, __ATOMIC_RELAXED);
+    uint64_t check = __atomic_load_n(&e->check, __ATOMIC_RELAXED);
+    memcpy(res, &data, sizeof(data));
+    return check ^ data;
+}
+
+
+bool tt_probe(uint64_t key, struct tt_data *res) {
+    REQUIRES(res != NULL);
+    struct tt_bucket *b = _bucket(key);
+    for (int i = 0; i < TT_BUCKET_ENTRIES; i++) {
+        if (_load(&b->entries[i], res) == key && res->bound != ttNone) return true;
+    }
+    return false;
+}
+
+
+void tt_store(uint64_t key, uint16_t move, int score, int depth, enum ttBound bound) {
+    REQUIRES(bound != ttNone);
+    struct tt_bucket *b = _bucket(key);
+    struct tt_entry *replace = NULL;
+    struct tt_data old = {0};
+    bool same = false;
+    int worst = 0;
+    for (int i = 0; i < TT_BUCKET_ENTRIES; i++) {
+        struct tt_data d;
+        same = _load(&b->entries[i], &d) == key;
+        if (same || d.bound == ttNone) {
+            replace = &b->entries[i];
+            old = d;
+            break;
+        }
+        // Entries from older searches go first, then the shallowest
+        int value = d.depth - 8 * (uint8_t) (search_age - d.age);
+        if (replace == NULL || value < worst) {
+            replace = &b->entries[i];
+            worst = value;
+        }
+    }
+    if (same && old.bound != ttNone && move == 0) move = old.move;  // Keep the old best move if this result has none
+
+    struct tt_data d = {move, (int16_t) score, (int8_t) depth, (uint8_t) bound, search_age, 0};
+    uint64_t data;
+    memcpy(&data, &d, sizeof(data));
+    __atomic_store_n(&replace->data, data, __ATOMIC_RELAXED);
+    __atomic_store_n(&replace->check, key ^ data, __ATOMIC_RELAXED);
+}
+
+
+double tt_probe_latency(int probes) {
+    REQUIRES(probes > 0);
+    tt_init();
+    static volatile int hits;  // Keeps the compiler from dropping probes whose result is unused
+    uint64_t state = 0x9E3779B97F4A7C15;
+    double start = omp_get_wtime();
+    for (int i = 0; i < probes; i++) {
+        state ^= state >> 12;  // xorshift64*: every probe lands on an unpredictable cache line and page
+        state ^= state << 25;
+        state ^= state >> 27;
+        struct tt_data d;
+        hits += tt_probe(state * 0x2545F4914F6CDD1D, &d);
+    }
+    double elapsed = omp_get_wtime() - start;
+    return elapsed * 1e9 / probes;
+}
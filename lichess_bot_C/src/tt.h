@@ -0,0 +1,101 @@
+//
+// Transposition table: shared by all search threads, sized at runtime, backed by huge pages where possible.
+//
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef CHESS_TT_H
+#define CHESS_TT_H
+
+#define TT_DEFAULT_MB 16
+#define TT_BUCKET_ENTRIES 4
+
+enum ttBound {ttNone=0, ttExact=1, ttLower=2, ttUpper=3};
+
+/**
+ * One stored search result. 8 bytes, so it packs into a tt_entry's data word
+ */
+struct tt_data {
+    uint16_t move;   // from | to << 6 | promotion << 12, with bit 15 set for drops (see search.c), or 0 for none
+    int16_t score;
+    int8_t depth;
+    uint8_t bound;   // enum ttBound
+    uint8_t age;     // Search number that stored it, for replacement
+    uint8_t padding;
+};
+
+/**
+ * 16 bytes, so a bucket fills one cache line and a probe costs one memory access.
+ * Threads read and write entries without locks. check holds the key XOR data: when two threads store into one
+ * entry at once, the entry can end up with one's check and the other's data, and then matches neither key
+ */
+struct tt_entry {
+    uint64_t check;  // history_key of the position ^ data
+    uint64_t data;   // struct tt_data
+};
+
+struct tt_bucket {
+    struct tt_entry entries[TT_BUCKET_ENTRIES];
+} __attribute__((aligned(64)));
+
+/**
+ * Resizes the table (UCI Hash option), discarding its contents. Exported for the Python (ctypes) side
+ * @param mb Megabytes, at least 1
+ */
+void tt_resize(size_t mb);
+
+/**
+ * Allocates a TT_DEFAULT_MB table unless tt_resize already did. Must run before search threads probe the table
+ */
+void tt_init(void);
+
+/**
+ * Whether tt_resize asks for huge pages (default true). Takes effect at the next tt_resize
+ * @param on
+ */
+void tt_set_huge_pages(bool on);
+
+/**
+ * @return Pages backing the table, as an enum pageKind (see lib/large_alloc.h)
+ */
+int tt_page_kind(void);
+
+/**
+ * Zeroes the table (UCI ucinewgame), split across OpenMP threads: each thread clears its own slice, which
+ * also places the slice's pages on the thread's NUMA node. Exported for the Python (ctypes) side
+ */
+void tt_clear(void);
+
+/**
+ * Marks the start of a new search, so entries from earlier searches are replaced first
+ */
+void tt_new_search(void);
+
+/**
+ * @param key
+ * @param res Receives the result stored for key, copied out of the table, so later stores by other threads
+ * cannot change it
+ * @return Whether key is stored
+ */
+bool tt_probe(uint64_t key, struct tt_data *res);
+
+/**
+ * Stores a search result, replacing the same position, or else the shallowest / oldest entry in the bucket
+ * @param key
+ * @param move
+ * @param score
+ * @param depth
+ * @param bound
+ */
+void tt_store(uint64_t key, uint16_t move, int score, int depth, enum ttBound bound);
+
+/**
+ * Times random probes of the current table, for bench_API.py. Exported for the Python (ctypes) side
+ * @param probes Number of probes
+ * @return Average nanoseconds per probe
+ */
+double tt_probe_latency(int probes);
+
+#endif //CHESS_TT_H
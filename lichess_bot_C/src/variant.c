@@ -0,0 +1,98 @@
+//
+// Variant rules, compiled in per build (see `make variants`): -DVARIANT=VARIANT_<name> picks one, and the
+// standard build (no -DVARIANT) compiles every hook below down to nothing.
+//
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "lib/contracts.h"
+#include "dataStructs.h"
+#include "board_manipulations.h"
+#include "variant.h"
+
+#define RANK_1 0x00000000000000FFUL
+#define RANK_8 0xFF00000000000000UL
+
+
+const char *engine_variant(void) {
+#if VARIANT == VARIANT_CHESS960
+    return "chess960";
+#elif VARIANT == VARIANT_THREECHECK
+    return "threecheck";
+#elif VARIANT == VARIANT_KOTH
+    return "koth";
+#elif VARIANT == VARIANT_CRAZYHOUSE
+    return "crazyhouse";
+#else
+    return "standard";
+#endif
+}
+
+
+/**
+ * HELPER FUNCTION LOCAL TO THIS FILE
+ * @return Squares from a to b on one rank, both included
+ */
+static uint64_t _span(enum enumSquare a, enum enumSquare b) {
+    enum enumSquare lo = (a < b) ? a : b, hi = (a < b) ? b : a;
+    return (2UL << hi) - (1UL << lo);
+}
+
+
+enum enumSquare castling_rook(FEN position, enum enumSquare kingDest) {
+    REQUIRES(position != NULL && (position->castling >> kingDest & 1));
+#if VARIANT == VARIANT_CHESS960
+    uint64_t rank = (kingDest < a2) ? RANK_1 : RANK_8;
+    uint64_t king = position->BBoard[(kingDest < a2) ? whiteKing : blackKing];
+    uint64_t side = (kingDest % 8 == 6) ? eastRay(bitScanForward(king)) : westRay(bitScanForward(king));
+    uint64_t rook = position->castlingRooks & rank & side;
+    ASSERT(rook != 0);
+    return bitScanForward(rook);
+#else
+    (void) position;  // Only read by REQUIRES
+    return (kingDest % 8 == 6) ? kingDest + 1 : kingDest - 2;  // h-file or a-file corner
+#endif
+}
+
+
+uint64_t castling_empty_squares(FEN position, enum enumSquare kingDest) {
+    REQUIRES(position != NULL);
+    enum enumSquare king = bitScanForward(position->BBoard[(kingDest < a2) ? whiteKing : blackKing]);
+    enum enumSquare rook = castling_rook(position, kingDest);
+    enum enumSquare rookDest = (kingDest % 8 == 6) ? kingDest - 1 : kingDest + 1;
+    return (_span(king, kingDest) | _span(rook, rookDest)) & ~((1UL << king) | (1UL << rook));
+}
+
+
+uint64_t castling_king_path(FEN position, enum enumSquare kingDest) {
+    REQUIRES(position != NULL);
+    enum enumSquare king = bitScanForward(position->BBoard[(kingDest < a2) ? whiteKing : blackKing]);
+    return _span(king, kingDest);
+}
+
+
+void make_castle(FEN position, enum enumSquare kingDest) {
+    REQUIRES(position != NULL);
+    bool white = kingDest < a2;
+    enum EPieceType kingPiece = white ? whiteKing : blackKing;
+    enum EPieceType rookPiece = white ? whiteRooks : blackRooks;
+    enum enumSquare king = bitScanForward(position->BBoard[kingPiece]);
+    enum enumSquare rook = castling_rook(position, kingDest);
+    enum enumSquare rookDest = (kingDest % 8 == 6) ? kingDest - 1 : kingDest + 1;
+
+    // Lift both pieces before placing either, since in Chess960 one may land where the other started
+    uint64_t lifted = (1UL << king) | (1UL << rook);
+    uint64_t placed = (1UL << kingDest) | (1UL << rookDest);
+    position->BBoard[kingPiece] = 1UL << kingDest;
+    position->BBoard[rookPiece] = (position->BBoard[rookPiece] & ~(1UL << rook)) | (1UL << rookDest);
+    enum EPieceType all = white ? whiteAll : blackAll;
+    position->BBoard[all] = (position->BBoard[all] & ~lifted) | placed;
+
+    uint64_t rank = white ? RANK_1 : RANK_8;
+    position->castling &= ~rank;
+#if VARIANT == VARIANT_CHESS960
+    position->castlingRooks &= ~rank;
+#endif
+}
@@ -0,0 +1,129 @@
+//
+// Variant rules, compiled in per build (see `make variants`): -DVARIANT=VARIANT_<name> picks one, and the
+// standard build (no -DVARIANT) compiles every hook below down to nothing.
+//
+
+#ifndef CHESS_VARIANT_H
+#define CHESS_VARIANT_H
+
+#define CENTRE_SQUARES 0x0000001818000000UL  // d4, e4, d5, e5
+#define VARIANT_WIN 10000  // Above KNOWN_WIN (see material.h), so reaching a variant win beats any evaluation
+
+/**
+ * @return Name of the variant this build plays (ie. "chess960", as in ChessEngine-chess960.so).
+ * Exported for the Python (ctypes) side
+ */
+const char *engine_variant(void);
+
+/**
+ * Rook that castles towards kingDest. In the standard build this is always the corner rook, so it folds to a
+ * constant; Chess960 looks it up in position->castlingRooks
+ * @param position
+ * @param kingDest g1, c1, g8 or c8, with that castling right in position->castling
+ * @return Square of the rook
+ */
+enum enumSquare castling_rook(FEN position, enum enumSquare kingDest);
+
+/**
+ * @param position
+ * @param kingDest As for castling_rook
+ * @return Squares that must be empty to castle: every square the king or rook crosses or lands on,
+ * apart from the squares the two of them start on
+ */
+uint64_t castling_empty_squares(FEN position, enum enumSquare kingDest);
+
+/**
+ * @param position
+ * @param kingDest As for castling_rook
+ * @return Squares the king stands on, crosses or lands on while castling, none of which may be attacked
+ */
+uint64_t castling_king_path(FEN position, enum enumSquare kingDest);
+
+/**
+ * Moves the king and rook of a castling move (either may land on the other's start square in Chess960),
+ * and removes both of that side's castling rights
+ * @param position
+ * @param kingDest As for castling_rook
+ */
+void make_castle(FEN position, enum enumSquare kingDest);
+
+
+/**
+ * Whether position plays drops: only in the Crazyhouse build, so the other builds skip every pocket hook. Their
+ * FENs may still carry a pocket field, which they parse and write back but search without
+ * @param position
+ * @return
+ */
+static inline bool variant_crazyhouse(FEN position) {
+#if VARIANT == VARIANT_CRAZYHOUSE
+    return position->crazyhouse;
+#else
+    (void) position;
+    return false;
+#endif
+}
+
+/**
+ * Whether the side to move has already lost by the variant's own rules (the opponent gave a third check, or
+ * has a king on the hill). Always false in the standard and Chess960 builds, so the call compiles away
+ * @param position
+ * @return
+ */
+static inline bool variant_lost(FEN position) {
+#if VARIANT == VARIANT_THREECHECK
+    return position->checksLeft[position->whiteToMove] == 0;  // Opponent's counter: [0] white, [1] black
+#elif VARIANT == VARIANT_KOTH
+    return (position->BBoard[position->whiteToMove ? blackKing : whiteKing] & CENTRE_SQUARES) != 0;
+#else
+    (void) position;
+    return false;
+#endif
+}
+
+/**
+ * Updates variant counters after make_move / make_castle, before the side to move changes. Nothing to do
+ * outside Three-check
+ * @param position
+ * @param givesCheck Whether the move just made checks the opponent
+ */
+static inline void variant_after_move(FEN position, bool givesCheck) {
+#if VARIANT == VARIANT_THREECHECK
+    if (givesCheck) position->checksLeft[!position->whiteToMove]--;
+#else
+    (void) position;
+    (void) givesCheck;
+#endif
+}
+
+/**
+ * Adds the variant's evaluation terms: checks already given (Three-check), or kings close to the hill (KOTH)
+ * @param position
+ * @param eval General (PeSTO) evaluation from the side to move's perspective
+ * @return Evaluation from the side to move's perspective
+ */
+static inline int variant_evaluate(FEN position, int eval) {
+#if VARIANT == VARIANT_THREECHECK
+    static const int given_bonus[4] = {0, 150, 500, 0};  // By checks given. A third ends the game
+    int us = !position->whiteToMove;  // checksLeft index of the side to move
+    return eval + given_bonus[3 - position->checksLeft[us]] - given_bonus[3 - position->checksLeft[!us]];
+#elif VARIANT == VARIANT_KOTH
+    static const int hill_bonus[8] = {0, 0, 0, 0, 20, 60, 150, 400};  // By 7 - distance to the nearest centre square
+    int res = 0;
+    for (int side = 0; side < 2; side++) {
+        uint64_t king = position->BBoard[side ? blackKing : whiteKing];
+        if (!king) continue;
+        enum enumSquare sq = bitScanForward(king);
+        int file = sq % 8, rank = sq / 8;
+        int dFile = (file < 3) ? 3 - file : (file > 4) ? file - 4 : 0;
+        int dRank = (rank < 3) ? 3 - rank : (rank > 4) ? rank - 4 : 0;
+        int distance = (dFile > dRank) ? dFile : dRank;
+        res += (side == !position->whiteToMove ? 1 : -1) * hill_bonus[7 - distance];
+    }
+    return eval + res;
+#else
+    (void) position;
+    return eval;
+#endif
+}
+
+#endif //CHESS_VARIANT_H
@@ -0,0 +1,80 @@
+//
+// parse_fen / write_fen round trip, and rejection of malformed FENs
+// Build and run with `make fentest`. Exits non-zero if any case fails
+//
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "../src/dataStructs.h"
+#include "../src/dev_tools.h"
+
+// Written exactly as write_fen writes them, so each must come back unchanged
+static const char *round_trip[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPP1PPP/RNBQKBNR w KQkq e6 0 2",
+    "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k3/8/8/8/8/8/8/4K2R w Kq - 99 150",
+    "4k3/8/8/8/8/8/8/4K3 b - - 2147483647 2147483647",
+    "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R[] w KQkq - 2 3",
+    "r1bQ~kb1r/ppp2ppp/2n5/8/8/8/PPPP1PPP/RNB1KBNR[QNPPbp] b KQ - 0 8",
+};
+
+// parse_fen must refuse every one of these
+static const char *malformed[] = {
+    "",
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP w KQkq - 0 1",            // Seven ranks
+    "rnbqkbnr/pppppppp/9/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",   // Nine files
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNX w KQkq - 0 1",   // Unknown piece
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBN\xd2 w KQkq - 0 1",  // 'R' with the high bit set
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR[Q\xd1] w KQkq - 0 1",  // 'Q' with the high bit set
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1",   // Side to move
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KKkq - 0 1",   // Repeated right
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq e4 0 1",  // En passant on the wrong rank
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 2147483648 1",  // Clock overflows an int
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 99999999999999999999",
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR[Kq] w KQkq - 0 1",  // King in a pocket
+    "~nbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",   // Promoted mark without a piece
+};
+
+
+int main(void) {
+    int failures = 0;
+    struct FEN_info position;
+    char written[FEN_MAX_LENGTH];
+
+    for (size_t i = 0; i < sizeof(round_trip) / sizeof(round_trip[0]); i++) {
+        if (parse_fen(round_trip[i], &position) == NULL) {
+            printf("FAIL parse: %s\n", round_trip[i]);
+            failures++;
+            continue;
+        }
+        write_fen(&position, written);
+        if (strcmp(written, round_trip[i]) != 0) {
+            printf("FAIL round trip: %s\n             got: %s\n", round_trip[i], written);
+            failures++;
+        }
+    }
+
+    // EPD records leave the clocks out, and get the defaults back
+    const char *epd = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - bm e4;";
+    const char *end = parse_fen(epd, &position);
+    if (end == NULL || strcmp(end, " bm e4;") != 0) {
+        printf("FAIL EPD: %s\n", epd);
+        failures++;
+    }
+
+    for (size_t i = 0; i < sizeof(malformed) / sizeof(malformed[0]); i++) {
+        if (parse_fen(malformed[i], &position) != NULL) {
+            printf("FAIL accepted: %s\n", malformed[i]);
+            failures++;
+        }
+    }
+
+    printf("%d failure(s)\n", failures);
+    return failures != 0;
+}
@@ -0,0 +1,39 @@
+//
+// Generates the king + pawn, rook and queen vs king bitbases into a directory, for bitbase_init to map at startup
+// Usage: bin/gen_bitbases [dir]   (run by `make bitbases`)
+//
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../src/dataStructs.h"
+#include "../src/lib/xalloc.h"
+#include "../src/bitbase.h"
+
+int main(int argc, char **argv) {
+    const char *dir = argc > 1 ? argv[1] : "bitbases";
+    uint64_t *bits = xmalloc(BITBASE_BYTES);
+
+    for (enum EPieceType piece = whitePawns; piece < whiteKing; piece++) {
+        if (bitbase_file_name(piece) == NULL) continue;
+        clock_t start = clock();
+        bitbase_generate(piece, bits);
+
+        int wins = 0;
+        for (int i = 0; i < BITBASE_POSITIONS / 64; i++) wins += __builtin_popcountll(bits[i]);
+
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s", dir, bitbase_file_name(piece));
+        FILE *f = fopen(path, "wb");
+        if (f == NULL || fwrite(bits, 1, BITBASE_BYTES, f) != BITBASE_BYTES) {
+            fprintf(stderr, "Could not write %s\n", path);
+            return 1;
+        }
+        fclose(f);
+        printf("%s: %d winning positions (%.2fs CPU)\n", path, wins, (double) (clock() - start) / CLOCKS_PER_SEC);
+    }
+    free(bits);
+    return 0;
+}
@@ -0,0 +1,106 @@
+//
+// Microbenchmark of lib/hmap.h against lib/hdict.c: insert, then look up present and absent keys
+// Build and run with `make hmapbench`
+//
+
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../src/lib/hmap.h"
+#include "../src/lib/hdict.h"
+
+#define NUM_KEYS 1000000
+
+DEFINE_HMAP(bench_map, uint64_t, int, hmap_hash_u64, hmap_eq_u64)
+
+/**
+ * hdict stores pointers to client entries, so every entry is its own allocation
+ */
+struct bench_entry {
+    uint64_t key;
+    int value;
+};
+
+
+static key _entry_key(entry e) {
+    return &((struct bench_entry *) e)->key;
+}
+
+
+static int _key_hash(key k) {
+    return (int) hmap_hash_u64(*(uint64_t *) k);
+}
+
+
+static bool _key_equiv(key a, key b) {
+    return *(uint64_t *) a == *(uint64_t *) b;
+}
+
+
+/**
+ * xorshift64*
+ */
+static uint64_t _rand64(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1D;
+}
+
+
+static double _seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+static void _report(const char *name, double insert, double hit, double miss, long found) {
+    printf("%-6s insert %6.1f ns  hit %6.1f ns  miss %6.1f ns  (%ld found)\n", name,
+           insert * 1e9 / NUM_KEYS, hit * 1e9 / NUM_KEYS, miss * 1e9 / NUM_KEYS, found);
+}
+
+
+int main(void) {
+    uint64_t *keys = malloc(2 * NUM_KEYS * sizeof(uint64_t));  // Second half are never inserted
+    uint64_t state = 0x9E3779B97F4A7C15;
+    for (int i = 0; i < 2 * NUM_KEYS; i++) keys[i] = _rand64(&state);
+    printf("%d random 64-bit keys, starting from an empty table of 16\n", NUM_KEYS);
+
+    struct bench_map m;
+    long found = 0;
+    double t0 = _seconds();
+    bench_map_init(&m, 16);
+    for (int i = 0; i < NUM_KEYS; i++) bench_map_put(&m, keys[i], i);
+    double t1 = _seconds();
+    for (int i = 0; i < NUM_KEYS; i++) found += bench_map_get(&m, keys[i]) != NULL;
+    double t2 = _seconds();
+    for (int i = NUM_KEYS; i < 2 * NUM_KEYS; i++) found += bench_map_get(&m, keys[i]) != NULL;
+    double t3 = _seconds();
+    _report("hmap", t1 - t0, t2 - t1, t3 - t2, found);
+    bench_map_free(&m);
+
+    struct bench_entry *entries = malloc(NUM_KEYS * sizeof(struct bench_entry));
+    found = 0;
+    t0 = _seconds();
+    hdict_t H = hdict_new(16, _entry_key, _key_hash, _key_equiv);
+    for (int i = 0; i < NUM_KEYS; i++) {
+        entries[i] = (struct bench_entry) {keys[i], i};
+        hdict_insert(H, &entries[i]);
+    }
+    t1 = _seconds();
+    for (int i = 0; i < NUM_KEYS; i++) found += hdict_lookup(H, &keys[i]) != NULL;
+    t2 = _seconds();
+    for (int i = NUM_KEYS; i < 2 * NUM_KEYS; i++) found += hdict_lookup(H, &keys[i]) != NULL;
+    t3 = _seconds();
+    _report("hdict", t1 - t0, t2 - t1, t3 - t2, found);
+    hdict_free(H);
+
+    free(entries);
+    free(keys);
+    return 0;
+}
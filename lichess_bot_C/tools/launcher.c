@@ -0,0 +1,36 @@
+//
+// Starts the most demanding bin/ChessEngine-<flavour>.o that both this CPU and the build directory provide
+//
+
+#define _POSIX_C_SOURCE 200809L  // execv, access
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+
+#include "../src/cpu_features.h"
+
+int main(int argc, char **argv) {
+    (void) argc;
+
+    // Flavoured binaries live next to this launcher
+    char dir[PATH_MAX];
+    strncpy(dir, argv[0], sizeof(dir) - 1);
+    dir[sizeof(dir) - 1] = '\0';
+    char *slash = strrchr(dir, '/');
+    if (slash != NULL) *slash = '\0';
+    else strcpy(dir, ".");
+
+    char path[PATH_MAX + 32];  // Room for the "/ChessEngine-<flavour>.o" suffix
+    for (int f = cpu_best_flavour(); f >= flavourGeneric; f--) {
+        snprintf(path, sizeof(path), "%s/ChessEngine-%s.o", dir, cpu_flavour_name(f));
+        if (access(path, X_OK) == 0) {
+            argv[0] = path;
+            execv(path, argv);
+            perror(path);  // Only reached if execv failed; try the next flavour down
+        }
+    }
+    fprintf(stderr, "No ChessEngine-<flavour>.o found in %s. Run `make flavours` first\n", dir);
+    return 1;
+}
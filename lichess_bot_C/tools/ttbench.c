@@ -0,0 +1,74 @@
+//
+// Transposition table probe latency with and without huge pages
+// Build and run with `make ttbench` (table size in MB as the optional argument, default 512)
+//
+
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../src/tt.h"
+#include "../src/lib/large_alloc.h"
+
+#define NUM_PROBES 20000000
+
+static const char *page_names[] = {"normal", "transparent huge", "explicit huge"};
+
+
+/**
+ * xorshift64* – random keys, so every probe lands on an unpredictable cache line and page
+ */
+static uint64_t _rand64(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1D;
+}
+
+
+static double _seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+static void _run(size_t mb, bool huge) {
+    tt_set_huge_pages(huge);
+    double start = _seconds();
+    tt_resize(mb);
+    double resized = _seconds();
+    tt_clear();
+    double cleared = _seconds();
+
+    uint64_t state = 0x9E3779B97F4A7C15;
+    for (size_t i = 0; i < (mb << 20) / sizeof(struct tt_entry) / 2; i++) {
+        tt_store(_rand64(&state) | 1, (uint16_t) i, 0, 1, ttExact);
+    }
+
+    state = 0x9E3779B97F4A7C15;
+    uint64_t hits = 0;
+    double probing = _seconds();
+    for (int i = 0; i < NUM_PROBES; i++) {
+        struct tt_data d;
+        hits += tt_probe(_rand64(&state) | 1, &d);
+    }
+    double done = _seconds();
+
+    printf("%-17s pages: resize %6.1f ms  clear %6.1f ms  probe %6.1f ns  (%.0f%% hits)\n",
+           page_names[tt_page_kind()], (resized - start) * 1e3, (cleared - resized) * 1e3,
+           (done - probing) * 1e9 / NUM_PROBES, 100.0 * hits / NUM_PROBES);
+}
+
+
+int main(int argc, char **argv) {
+    size_t mb = (argc > 1) ? strtoul(argv[1], NULL, 10) : 512;
+    if (mb == 0) mb = 1;
+    printf("Transposition table: %zu MB, %d random probes\n", mb, NUM_PROBES);
+    _run(mb, false);
+    _run(mb, true);
+    return 0;
+}
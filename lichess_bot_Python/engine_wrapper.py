@@ -8,7 +8,7 @@ logger = logging.getLogger(__name__)
 
 
 @backoff.on_exception(backoff.expo, BaseException, max_time=120)
-def create_engine(config):
+def create_engine(config, root_search=None):
     cfg = config["engine"]
     engine_path = os.path.join(cfg["dir"], cfg["name"])
     engine_type = cfg.get("protocol")
@@ -30,9 +30,26 @@ def create_engine(config):
         raise ValueError(
             f"    Invalid engine type: {engine_type}. Expected xboard, uci, or homemade.")
     options = remove_managed_options(cfg.get(engine_type + "_options", {}) or {})
+    if root_search is not None:
+        return Engine(commands, options, stderr, root_search=root_search)
     return Engine(commands, options, stderr)
 
 
+def start_root_search(config, concurrency):
+    """Starts the search pool of a homemade engine that shares one across games (see CaspersMiniMax), or returns None"""
+    cfg = config["engine"]
+    if cfg.get("protocol") != "homemade":
+        return None
+    Engine = getHomemadeEngine(cfg["name"])
+    if not hasattr(Engine, "start_root_search"):
+        return None
+    return Engine.start_root_search(cfg.get("homemade_options", {}) or {}, concurrency)
+
+
+def stop_root_search(config, root_search):
+    getHomemadeEngine(config["engine"]["name"]).stop_root_search(root_search)
+
+
 def remove_managed_options(config):
     def is_managed(key):
         return chess.engine.Option(key, None, None, None, None, None).is_managed()
@@ -9,9 +9,62 @@
 
 import random
 import time
+import os
+import ctypes
+import functools
+import multiprocessing
+import multiprocessing.managers
+import queue
+import threading
+
+# Shared library built by `make lichess` in lichess_bot_C, which sits next to this file in the repository root.
+# None if it has not been built, or for the copies of this file under lichess_bot_Python (the Python engine
+# is used instead)
+@functools.lru_cache(maxsize=None)
+def loadCEngine():
+    soFile = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                          "lichess_bot_C", "lichess_bot", "engines", "ChessEngine.so")
+    if not os.path.exists(soFile):
+        return None
+    try:
+        engine = ctypes.CDLL(soFile)
+        engine.lichess.restype = ctypes.c_char_p
+        engine.search_set_depth.argtypes = [ctypes.c_int]
+        return engine
+    except (OSError, AttributeError):
+        return None
+
+# The C engine's search state is global, so it runs one search at a time: CEngineMove holds this while searching
+cEngineLock = threading.Lock()
+
+# Runs the C engine's search of fen, to depth plies. Setting stop (a threading.Event) ends it early through
+# tm_stop, repeated until the search returns, since the search clears a stop sent before it started its clock
+def searchCEngine(engine, fen, depth, stop):
+    with cEngineLock:
+        done = threading.Event()
+        def watch():
+            while not done.wait(0.05):
+                if stop.is_set(): engine.tm_stop()
+        watcher = threading.Thread(target = watch, daemon = True)
+        if stop != None: watcher.start()
+        try:
+            engine.search_set_depth(depth)
+            return engine.lichess(bytes(fen, 'ascii'), b"")
+        finally:
+            done.set()
+            if stop != None: watcher.join()
+
+# Search constants. Bounds say how a transposition table score relates to the position's true score
+MATE_SCORE = 100000
+EXACT, LOWER, UPPER = 0, 1, 2
+
+# Raised inside the search when its time is up, to unwind back to AIMove
+class SearchTimeout(Exception):
+    pass
 
 class ChessEngine(object):
     stalemate = False
+    searchCount = 0    # number of AIMove calls, so pool processes know when to clear their transpositions
 
     def isLegalMove(self, board, currentRow, currentCol, nextRow, nextCol):
         dRow, dCol = nextRow - currentRow, nextCol - currentCol
@@ -64,14 +117,14 @@ class ChessEngine(object):
     @staticmethod
     def isInCheck(board, kingRow, kingCol): # This is a more efficient implementation of check
         #Check by knight
-        for (drow, dcol) in Knight('opponent color').moves:
+        for (drow, dcol) in KNIGHT_MOVES:
             checkRow, checkCol = kingRow + drow, kingCol + dcol
             if ((0 <= checkRow < len(board) and 0 <= checkCol < len(board)) and isinstance(board[checkRow][checkCol], Knight)
                 and board[checkRow][checkCol].color != board[kingRow][kingCol].color):
                 return True
 
         #Check by other pieces: check for pins / obstacles
-        for (drow, dcol) in Queen('opponent color').moves:
+        for (drow, dcol) in QUEEN_MOVES:
             checkRow, checkCol = kingRow + drow, kingCol + dcol
             if ((0 <= checkRow < len(board) and 0 <= checkCol < len(board)) and board[checkRow][checkCol] != None
                 and board[checkRow][checkCol].color != board[kingRow][kingCol].color):
@@ -150,22 +203,8 @@ class ChessEngine(object):
     # Check if there are any moves possible for opponent (ie. intercept check)
     @staticmethod
     def isInMate(board, kingRow, kingCol, crazyhousePieces):
-        # Same algorithm as the generateMoves function, but returns bool as soon as move is found (faster)
-        for row in range(len(board)):
-            for col in range(len(board[row])):
-                if board[row][col] != None and board[row][col].color == board[kingRow][kingCol].color:
-                    for (drow, dcol) in board[row][col].moves:
-                        nextRow, nextCol = row + drow, col + dcol
-                        if (0 <= nextRow < len(board) and 0 <= nextCol < len(board) and
-                            ChessEngine.tryMove(board, row, col, nextRow, nextCol)): 
-                            return False    # there are possible moves!
-                    if isinstance(board[row][col], Pawn):    # Pawn has special moves
-                        for (drow, dcol) in board[row][col].attackMoves + board[row][col].doubleMove:
-                            nextRow, nextCol = row + drow, col + dcol
-                            if (0 <= nextRow < len(board) and 0 <= nextCol < len(board) and
-                                ChessEngine.tryMove(board, row, col, nextRow, nextCol)): 
-                                return False
-                    # King cannot castle to get out of a check. So we can ignore castle as possible move
+        if Mailbox(board, board[kingRow][kingCol].color).legalMoves() != []:
+            return False    # there are possible moves!
         if crazyhousePieces != None:    # In crazyhouse variant, can intercept check by dropping pieces
             # setting up – gets the playing color and corresponding dictionary
             pieces = [Queen, Rook, Bishop, Knight, Pawn]
@@ -208,27 +247,8 @@ class ChessEngine(object):
 
     @staticmethod
     def generateMoves(board, color):
-        possibleMoves = []
-        for row in range(len(board)):
-            for col in range(len(board[row])):
-                if board[row][col] != None and board[row][col].color == color:
-                    for (drow, dcol) in board[row][col].moves:
-                        nextRow, nextCol = row + drow, col + dcol
-                        if (0 <= nextRow < len(board) and 0 <= nextCol < len(board) and
-                            ChessEngine.tryMove(board, row, col, nextRow, nextCol)):
-                            possibleMoves += [(row, col, nextRow, nextCol)]
-                    if isinstance(board[row][col], Pawn):    # Pawn has special moves
-                        for (drow, dcol) in board[row][col].attackMoves + board[row][col].doubleMove:
-                            nextRow, nextCol = row + drow, col + dcol
-                            if (0 <= nextRow < len(board) and 0 <= nextCol < len(board) and
-                                ChessEngine.tryMove(board, row, col, nextRow, nextCol)): 
-                                possibleMoves += [(row, col, nextRow, nextCol)]
-                    elif isinstance(board[row][col], King) and not board[row][col].hasMoved: # King can castle
-                        for (drow, dcol) in [(0, 2), (0, -2)]:
-                            nextRow, nextCol = row + drow, col + dcol
-                            if ChessEngine.tryMove(board, row, col, nextRow, nextCol):
-                                possibleMoves += [(row, col, nextRow, nextCol)]
-        return possibleMoves
+        position = Mailbox(board, color)
+        return [ROW_COL[start] + ROW_COL[end] for (start, end) in position.legalMoves()]
 
     @staticmethod
     def positionEvaluation(board):
@@ -239,78 +259,131 @@ class ChessEngine(object):
                     points += board[row][col].points
         return (points, [])
 
+    # Sorts moves best-first for alpha-beta: the transposition table's move, then captures of the most valuable
+    # piece by the least valuable one, then quiet moves
+    @staticmethod
+    def orderMoves(position, moves, hashMove = None):
+        squares = position.squares
+        def moveOrder(move):
+            if move == hashMove:
+                return -1000000
+            victim = squares[move[1]]
+            if victim == EMPTY:
+                return 0
+            return -(abs(PIECE_POINTS[victim]) * 100 - abs(PIECE_POINTS[squares[move[0]]]))
+        moves.sort(key = moveOrder)
+        return moves
+
+    # Negamax with alpha-beta pruning on a Mailbox: returns (score, best move), score from the point of view
+    # of the side to move. transpositions is the search's table: Zobrist key -> (depth, score, bound, best move).
+    # Stops (raising SearchTimeout) at deadline, or once stop (a threading.Event) is set
     @staticmethod
-    def maxi(board, alpha, beta, depth):    # White wants to maximize (white pieces +)
+    def negamax(position, alpha, beta, depth, ply, deadline, transpositions, stop = None):
+        if (deadline != None and time.time() > deadline) or (stop != None and stop.is_set()):
+            raise SearchTimeout()
         if depth == 0:    # base case
-            return ChessEngine.positionEvaluation(board)
-        # recursive case
-        possibleMoves = ChessEngine.generateMoves(board, 'w')
-        bestMoves = []
-        alpha, beta = -100000, 100000    
-        for (row, col, nextRow, nextCol) in possibleMoves:
-            # make move
-            temp = board[nextRow][nextCol]
-            board[nextRow][nextCol] = board[row][col]
-            board[row][col] = None
-            # evaluate move
-            (points, enemyMoves) = ChessEngine.mini(board, alpha, beta, depth - 1)
-            # undo move
-            board[row][col] = board[nextRow][nextCol]
-            board[nextRow][nextCol] = temp
+            return (position.material if position.side == 0 else -position.material, None)
+
+        # Transposition table: reuse earlier results, or at least search their best move first
+        key = position.hash
+        originalAlpha = alpha
+        hashMove = None
+        if key in transpositions:
+            (storedDepth, storedScore, bound, hashMove) = transpositions[key]
+            if storedDepth >= depth and ply > 0:
+                if bound == EXACT: return (storedScore, hashMove)
+                elif bound == LOWER: alpha = max(alpha, storedScore)
+                elif bound == UPPER: beta = min(beta, storedScore)
+                if alpha >= beta: return (storedScore, hashMove)
+
+        possibleMoves = position.pseudoLegalMoves()
+        if ply == 0:
+            random.shuffle(possibleMoves)    # so equal moves are picked at random, as before
+        ChessEngine.orderMoves(position, possibleMoves, hashMove)
+
+        bestScore, bestMove = -MATE_SCORE - 1, None
+        for move in possibleMoves:
+            undo = position.makeMove(move)
+            if position.isAttacked(position.kings[position.side ^ BLACK], position.side):
+                position.undoMove(undo)    # leaves own king in check: not legal
+                continue
+            try:
+                score = -ChessEngine.negamax(position, -beta, -alpha, depth - 1, ply + 1, deadline, transpositions,
+                                             stop)[0]
+            finally:
+                position.undoMove(undo)
 
             # check if move was good
-            if points > beta:
-                return (100000, [])    # Beta-cutoff (a previous move had better outcome)
+            if score > bestScore:
+                bestScore, bestMove = score, move
+            alpha = max(alpha, score)
+            if alpha >= beta:
+                break    # Beta-cutoff (opponent will not allow this line)
+
+        if bestMove == None:    # no legal moves: checkmate (sooner is worse) or stalemate
+            return (-MATE_SCORE + ply if position.inCheck() else 0, None)
 
-            if points > alpha:
-                alpha = points
-                bestMoves = [(row, col, nextRow, nextCol, points)]
-            elif points == alpha: 
-                bestMoves += [(row, col, nextRow, nextCol, points)]
-        return (alpha, bestMoves)
+        if bestScore <= originalAlpha: bound = UPPER
+        elif bestScore >= beta: bound = LOWER
+        else: bound = EXACT
+        transpositions[key] = (depth, bestScore, bound, bestMove)
+        return (bestScore, bestMove)
 
+    # One iteration of AIMove split over the processes of rootSearch (a RootSearchService): the first root move
+    # is searched alone to get a score to beat, then the others in parallel. Returns (score, best move) like negamax
     @staticmethod
-    def mini(board, alpha, beta, depth):    # Black wants to minimize (black pieces -)
-        if depth == 0:    # base case
-            return ChessEngine.positionEvaluation(board)
-        
-        # recursive case
-        possibleMoves = ChessEngine.generateMoves(board, 'b')
-        bestMoves = []
-        alpha, beta = -100000, 100000    
-        for (row, col, nextRow, nextCol) in possibleMoves:
-            # make move
-            temp = board[nextRow][nextCol]
-            board[nextRow][nextCol] = board[row][col]
-            board[row][col] = None
-            # evaluate move
-            (points, enemyMoves) = ChessEngine.maxi(board, alpha, beta, depth - 1)
-            # undo move
-            board[row][col] = board[nextRow][nextCol]
-            board[nextRow][nextCol] = temp
+    def searchRootParallel(position, depth, deadline, transpositions, rootSearch):
+        moves = position.legalMoves()
+        if moves == []:
+            return ChessEngine.negamax(position, -MATE_SCORE - 1, MATE_SCORE + 1, depth, 0, deadline,
+                                       transpositions)
+        random.shuffle(moves)    # so equal moves are picked at random, as before
+        previousBest = transpositions.get(position.hash, (None, None, None, None))[3]
+        ChessEngine.orderMoves(position, moves, previousBest)
 
-            # check if move was good
-            if points < alpha:
-                return (-100000, [])    # Alpha-cutoff (a previous move had better outcome)
-            
-            if points < beta:
-                beta = points
-                bestMoves = [(row, col, nextRow, nextCol, points)]
-            elif points == beta: 
-                bestMoves += [(row, col, nextRow, nextCol, points)]
-        return (beta, bestMoves)
+        searchId = (os.getpid(), ChessEngine.searchCount)    # unique across the games sharing rootSearch
+        results = rootSearch.searchRoot(position.compact(), moves, depth, deadline, searchId)
+
+        bestScore, bestMove = -MATE_SCORE - 1, None
+        for (move, score) in results:
+            if score == None:
+                raise SearchTimeout()
+            if score > bestScore:
+                bestScore, bestMove = score, move
+        transpositions[position.hash] = (depth, bestScore, EXACT, bestMove)
+        return (bestScore, bestMove)
 
+    # Iterative deepening up to depth, stopping early once timeLimit seconds have passed. Depth one always
+    # finishes. From depth three on, rootSearch (see startRootSearch) splits the root moves over its processes.
+    # Setting stop (a threading.Event) from another thread cancels the search. Returns the move of the deepest
+    # finished search (bot mode), or else makes it on the board
     @staticmethod
-    def AIMove(board, color, depth, bot = False):
-        # Find best move
-        if color == 'b':
-            (score, bestMoves) = ChessEngine.mini((board), -100000, 100000, depth)
-        elif color == 'w':
-            (score, bestMoves) = ChessEngine.maxi((board), -100000, 100000, depth)
+    def AIMove(board, color, depth, bot = False, timeLimit = 10, rootSearch = None, stop = None):
+        # Find best move. Each search has its own transposition table, so searches may run side by side
+        transpositions = {}
+        ChessEngine.searchCount += 1
+        position = Mailbox(board, color)
+        deadline = time.time() + timeLimit
+        bestMove = None
+        for currentDepth in range(1, depth + 1):
+            if stop != None and stop.is_set():
+                break
+            try:
+                if rootSearch != None and currentDepth >= 3:
+                    (score, move) = ChessEngine.searchRootParallel(position, currentDepth, deadline, transpositions,
+                                                                   rootSearch)
+                else:
+                    (score, move) = ChessEngine.negamax(position, -MATE_SCORE - 1, MATE_SCORE + 1, currentDepth, 0,
+                                                        deadline if currentDepth > 1 else None, transpositions, stop)
+            except SearchTimeout:
+                break
+            bestMove = move
+            if abs(score) >= MATE_SCORE - currentDepth:
+                break    # Found a forced mate; searching deeper will not change the move
 
         # Make move
-        if len(bestMoves) == 0: return
-        (row, col, nextRow, nextCol, points) = random.choice(bestMoves)
+        if bestMove == None: return
+        (row, col, nextRow, nextCol) = ROW_COL[bestMove[0]] + ROW_COL[bestMove[1]]
         if bot:
             return (row, col, nextRow, nextCol)
         board[nextRow][nextCol] = board[row][col]
@@ -321,7 +394,71 @@ class ChessEngine(object):
         if color == 'w': whiteToMove = True
         else: whiteToMove = False
         ChessEngine.checkGameState(board, whiteToMove)
-    
+
+    # FEN of the board with color to move. There is no en passant in this engine, and castling rights
+    # come from the hasMoved flags of kings and rooks still on their starting squares
+    @staticmethod
+    def boardToFen(board, color):
+        pieceLetters = {King: 'k', Queen: 'q', Bishop: 'b', Knight: 'n', Rook: 'r', Pawn: 'p'}
+        ranks = []
+        for row in range(len(board)):
+            rank, empty = "", 0
+            for col in range(len(board[row])):
+                piece = board[row][col]
+                if piece == None:
+                    empty += 1
+                    continue
+                if empty > 0: rank += str(empty)
+                empty = 0
+                letter = pieceLetters[type(piece)]
+                rank += letter.upper() if piece.color == 'w' else letter
+            if empty > 0: rank += str(empty)
+            ranks += [rank]
+
+        castling = ""
+        for (row, pieceColor, kingSide, queenSide) in [(7, 'w', 'K', 'Q'), (0, 'b', 'k', 'q')]:
+            king = board[row][4]
+            if not (isinstance(king, King) and king.color == pieceColor and not king.hasMoved): continue
+            for (col, right) in [(7, kingSide), (0, queenSide)]:
+                rook = board[row][col]
+                if isinstance(rook, Rook) and rook.color == pieceColor and not rook.hasMoved:
+                    castling += right
+        if castling == "": castling = "-"
+        return f"{'/'.join(ranks)} {color} {castling} - 0 1"
+
+    # Asks the C engine (lichess_bot_C) for a move, searching depth plies as AIMove would, which is much
+    # faster. Falls back to AIMove if the library is not built, or if its move is not one this engine allows
+    # (ie. en passant). Setting stop (a threading.Event) cancels either search, and then no move is returned.
+    # With bot, returns (row, col, nextRow, nextCol, promotePiece), promotePiece None unless the move promotes
+    @staticmethod
+    def CEngineMove(board, color, depth, bot = False, stop = None):
+        engine = loadCEngine()
+        if engine == None:
+            return ChessEngine.AIMove(board, color, depth, bot, stop = stop)
+        UCIMove = searchCEngine(engine, ChessEngine.boardToFen(board, color), depth, stop)
+        if stop != None and stop.is_set():
+            return None
+        if UCIMove == None or not (4 <= len(UCIMove) <= 5):
+            return ChessEngine.AIMove(board, color, depth, bot, stop = stop)
+        UCIMove = UCIMove.decode()
+        files = "abcdefgh"
+        try:
+            row, col = 8 - int(UCIMove[1]), files.index(UCIMove[0])
+            nextRow, nextCol = 8 - int(UCIMove[3]), files.index(UCIMove[2])
+        except ValueError:
+            return ChessEngine.AIMove(board, color, depth, bot, stop = stop)
+        if (row, col, nextRow, nextCol) not in ChessEngine.generateMoves(board, color):
+            return ChessEngine.AIMove(board, color, depth, bot, stop = stop)
+        promotePiece = UCIMove[4] if len(UCIMove) == 5 else None
+        if bot:
+            return (row, col, nextRow, nextCol, promotePiece)
+
+        # Make move, then check rules & game status (ie. checkmates), as in AIMove
+        board[nextRow][nextCol] = board[row][col]
+        board[row][col] = None
+        ChessEngine.specialRules(board, nextRow, nextCol, promotePiece == None, promotePiece)
+        ChessEngine.checkGameState(board, color == 'w')
+
     @staticmethod
     def tryCrazyhouseMove(board, previousRow, previousCol, row, col):
         pieces = [Queen, Rook, Bishop, Knight, Pawn]
@@ -453,4 +590,312 @@ class Pawn(ChessEngine):
     def __eq__(self, other):
         return isinstance(other, Pawn) and self.color == other.color
     def __hash__(self):
-        return hash(("Pawn", self.color))
\ No newline at end of file
+        return hash(("Pawn", self.color))
+
+
+# 10x12 mailbox board used by the search. The 8x8 board (row 0 is rank 8, as in board[row][col]) sits inside
+# a border of OFFBOARD squares, two deep above and below, so no knight jump or ray step leaves the list
+EMPTY, PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING = 0, 1, 2, 3, 4, 5, 6
+BLACK = 8    # colour bit of a piece code, and the side to move when black
+OFFBOARD = 16
+PIECE_CODES = {Pawn: PAWN, Knight: KNIGHT, Bishop: BISHOP, Rook: ROOK, Queen: QUEEN, King: KING}
+PIECE_POINTS = [0, 10, 30, 30, 50, 90, 900, 0, 0, -10, -30, -30, -50, -90, -900, 0]    # indexed by piece code
+WHITE_KINGSIDE, WHITE_QUEENSIDE, BLACK_KINGSIDE, BLACK_QUEENSIDE = 1, 2, 4, 8
+
+KNIGHT_OFFSETS = (-21, -19, -12, -8, 8, 12, 19, 21)
+KING_OFFSETS = (-11, -10, -9, -1, 1, 9, 10, 11)
+BISHOP_OFFSETS = (-11, -9, 9, 11)
+ROOK_OFFSETS = (-10, -1, 1, 10)
+
+def mailboxSquare(row, col):
+    return 21 + 10 * row + col
+
+BOARD_SQUARES = [mailboxSquare(row, col) for row in range(8) for col in range(8)]
+ROW_COL = [(square // 10 - 2, square % 10 - 1) for square in range(120)]    # inverse of mailboxSquare
+
+# Precomputed per square: on-board targets of knight and king jumps, and the squares along each ray in order
+KNIGHT_TARGETS = [[] for square in range(120)]
+KING_TARGETS = [[] for square in range(120)]
+BISHOP_RAYS = [[] for square in range(120)]
+ROOK_RAYS = [[] for square in range(120)]
+
+def precomputeMoveTables():
+    for square in BOARD_SQUARES:
+        KNIGHT_TARGETS[square] = [square + offset for offset in KNIGHT_OFFSETS if square + offset in BOARD_SQUARES]
+        KING_TARGETS[square] = [square + offset for offset in KING_OFFSETS if square + offset in BOARD_SQUARES]
+        for (rays, offsets) in [(BISHOP_RAYS, BISHOP_OFFSETS), (ROOK_RAYS, ROOK_OFFSETS)]:
+            for offset in offsets:
+                ray, target = [], square + offset
+                while target in BOARD_SQUARES:
+                    ray += [target]
+                    target += offset
+                if ray != []: rays[square] += [ray]
+
+precomputeMoveTables()
+
+# Castling rights kept after a move from or to each square (moving the king or a rook, or capturing a rook)
+CASTLING_MASKS = [15] * 120
+CASTLING_MASKS[mailboxSquare(7, 4)] = 15 & ~(WHITE_KINGSIDE | WHITE_QUEENSIDE)
+CASTLING_MASKS[mailboxSquare(7, 7)] = 15 & ~WHITE_KINGSIDE
+CASTLING_MASKS[mailboxSquare(7, 0)] = 15 & ~WHITE_QUEENSIDE
+CASTLING_MASKS[mailboxSquare(0, 4)] = 15 & ~(BLACK_KINGSIDE | BLACK_QUEENSIDE)
+CASTLING_MASKS[mailboxSquare(0, 7)] = 15 & ~BLACK_KINGSIDE
+CASTLING_MASKS[mailboxSquare(0, 0)] = 15 & ~BLACK_QUEENSIDE
+
+# Zobrist keys: the position key is the XOR of one random number per (piece, square), side and castling rights
+ZOBRIST_RANDOM = random.Random(2021)    # fixed seed, so keys are the same every run
+ZOBRIST_PIECES = [[ZOBRIST_RANDOM.getrandbits(64) for square in range(120)] for piece in range(16)]
+ZOBRIST_BLACK = ZOBRIST_RANDOM.getrandbits(64)
+ZOBRIST_CASTLING = [ZOBRIST_RANDOM.getrandbits(64) for rights in range(16)]
+
+class Mailbox(object):
+    # Copies board (lists of Piece objects) with color to move. Castling rights come from the hasMoved flags
+    def __init__(self, board, color):
+        codes = []
+        for row in range(8):
+            for col in range(8):
+                piece = board[row][col]
+                if piece == None: codes += [EMPTY]
+                else: codes += [PIECE_CODES[type(piece)] | (BLACK if piece.color == 'b' else 0)]
+        castling = 0
+        for (row, rights, rookCol) in [(7, WHITE_KINGSIDE, 7), (7, WHITE_QUEENSIDE, 0),
+                                       (0, BLACK_KINGSIDE, 7), (0, BLACK_QUEENSIDE, 0)]:
+            king, rook = board[row][4], board[row][rookCol]
+            if (isinstance(king, King) and not king.hasMoved and isinstance(rook, Rook) and not rook.hasMoved
+                and king.color == rook.color == ('w' if row == 7 else 'b')):
+                castling |= rights
+        self.setUp(codes, 0 if color == 'w' else BLACK, castling)
+
+    # Fills in the position from the 64 piece codes (row by row, as board[row][col]), side to move and castling
+    def setUp(self, codes, side, castling):
+        self.squares = [OFFBOARD] * 120
+        self.kings = {0: None, BLACK: None}    # king square of each side
+        self.side = side
+        self.castling = castling
+        self.material = 0    # positionEvaluation of the board, kept up to date by makeMove
+        self.hash = ZOBRIST_CASTLING[castling] ^ (ZOBRIST_BLACK if side == BLACK else 0)
+        for (square, code) in zip(BOARD_SQUARES, codes):
+            self.squares[square] = code
+            if code == EMPTY: continue
+            self.material += PIECE_POINTS[code]
+            self.hash ^= ZOBRIST_PIECES[code][square]
+            if code & 7 == KING: self.kings[code & BLACK] = square
+
+    # Small tuple of ints describing the position, cheap to send to another process (see fromCompact)
+    def compact(self):
+        return (tuple(self.squares[square] for square in BOARD_SQUARES), self.side, self.castling)
+
+    @staticmethod
+    def fromCompact(state):
+        position = Mailbox.__new__(Mailbox)
+        position.setUp(*state)
+        return position
+
+    # Whether a piece of side byColor (0 or BLACK) attacks square. Looks outwards from square, so only
+    # the squares a piece could attack it from are read
+    def isAttacked(self, square, byColor):
+        squares = self.squares
+        pawn = PAWN | byColor
+        if byColor == 0 and (squares[square + 9] == pawn or squares[square + 11] == pawn): return True
+        if byColor == BLACK and (squares[square - 9] == pawn or squares[square - 11] == pawn): return True
+        knight, king = KNIGHT | byColor, KING | byColor
+        for target in KNIGHT_TARGETS[square]:
+            if squares[target] == knight: return True
+        for target in KING_TARGETS[square]:
+            if squares[target] == king: return True
+        queen = QUEEN | byColor
+        for (rays, slider) in [(BISHOP_RAYS, BISHOP | byColor), (ROOK_RAYS, ROOK | byColor)]:
+            for ray in rays[square]:
+                for target in ray:
+                    piece = squares[target]
+                    if piece != EMPTY:
+                        if piece == slider or piece == queen: return True
+                        break
+        return False
+
+    def inCheck(self):
+        return self.isAttacked(self.kings[self.side], self.side ^ BLACK)
+
+    # Moves (from, to) of the side to move that follow piece movement, but may leave its king in check
+    def pseudoLegalMoves(self):
+        squares, side = self.squares, self.side
+        enemy = side ^ BLACK
+        moves = []
+        for square in BOARD_SQUARES:
+            piece = squares[square]
+            if piece == EMPTY or piece & BLACK != side: continue
+            kind = piece & 7
+            if kind == PAWN:
+                forward = -10 if side == 0 else 10
+                if squares[square + forward] == EMPTY:
+                    moves += [(square, square + forward)]
+                    startRow = 6 if side == 0 else 1
+                    if ROW_COL[square][0] == startRow and squares[square + 2 * forward] == EMPTY:
+                        moves += [(square, square + 2 * forward)]
+                for target in (square + forward - 1, square + forward + 1):
+                    if squares[target] != OFFBOARD and squares[target] != EMPTY and squares[target] & BLACK == enemy:
+                        moves += [(square, target)]
+            elif kind == KNIGHT or kind == KING:
+                for target in (KNIGHT_TARGETS if kind == KNIGHT else KING_TARGETS)[square]:
+                    if squares[target] == EMPTY or squares[target] & BLACK == enemy:
+                        moves += [(square, target)]
+            else:
+                rays = []
+                if kind != ROOK: rays += BISHOP_RAYS[square]
+                if kind != BISHOP: rays += ROOK_RAYS[square]
+                for ray in rays:
+                    for target in ray:
+                        if squares[target] == EMPTY:
+                            moves += [(square, target)]
+                        else:
+                            if squares[target] & BLACK == enemy: moves += [(square, target)]
+                            break
+
+        # Castling: squares between king and rook empty, and the king not in, through or into check
+        king = self.kings[side]
+        kingSide, queenSide = (WHITE_KINGSIDE, WHITE_QUEENSIDE) if side == 0 else (BLACK_KINGSIDE, BLACK_QUEENSIDE)
+        if self.castling & kingSide and squares[king + 1] == squares[king + 2] == EMPTY:
+            if not (self.isAttacked(king, enemy) or self.isAttacked(king + 1, enemy)):
+                moves += [(king, king + 2)]
+        if self.castling & queenSide and squares[king - 1] == squares[king - 2] == squares[king - 3] == EMPTY:
+            if not (self.isAttacked(king, enemy) or self.isAttacked(king - 1, enemy)):
+                moves += [(king, king - 2)]
+        return moves
+
+    # Makes move (pawns reaching the last rank become queens). Returns what undoMove needs to take it back
+    def makeMove(self, move):
+        (start, end) = move
+        squares = self.squares
+        piece, captured = squares[start], squares[end]
+        undo = (start, end, piece, captured, self.castling, self.hash, self.material)
+        placed = piece
+        if piece & 7 == PAWN and (end < 31 or end > 88):
+            placed = QUEEN | (piece & BLACK)
+        squares[start], squares[end] = EMPTY, placed
+        self.hash ^= ZOBRIST_PIECES[piece][start] ^ ZOBRIST_PIECES[placed][end]
+        self.material += PIECE_POINTS[placed] - PIECE_POINTS[piece] - PIECE_POINTS[captured]
+        if captured != EMPTY:
+            self.hash ^= ZOBRIST_PIECES[captured][end]
+        if piece & 7 == KING:
+            self.kings[piece & BLACK] = end
+            if abs(end - start) == 2:    # castling: move the rook too
+                (rookStart, rookEnd) = (start + 3, start + 1) if end > start else (start - 4, start - 1)
+                rook = squares[rookStart]
+                squares[rookStart], squares[rookEnd] = EMPTY, rook
+                self.hash ^= ZOBRIST_PIECES[rook][rookStart] ^ ZOBRIST_PIECES[rook][rookEnd]
+        newCastling = self.castling & CASTLING_MASKS[start] & CASTLING_MASKS[end]
+        self.hash ^= ZOBRIST_CASTLING[self.castling] ^ ZOBRIST_CASTLING[newCastling] ^ ZOBRIST_BLACK
+        self.castling = newCastling
+        self.side ^= BLACK
+        return undo
+
+    def undoMove(self, undo):
+        (start, end, piece, captured, self.castling, self.hash, self.material) = undo
+        squares = self.squares
+        squares[start], squares[end] = piece, captured
+        self.side ^= BLACK
+        if piece & 7 == KING:
+            self.kings[piece & BLACK] = start
+            if abs(end - start) == 2:
+                (rookStart, rookEnd) = (start + 3, start + 1) if end > start else (start - 4, start - 1)
+                squares[rookStart], squares[rookEnd] = squares[rookEnd], EMPTY
+
+    # Moves of the side to move that do not leave its own king in check
+    def legalMoves(self):
+        moves = []
+        for move in self.pseudoLegalMoves():
+            undo = self.makeMove(move)
+            if not self.isAttacked(self.kings[self.side ^ BLACK], self.side):
+                moves += [move]
+            self.undoMove(undo)
+        return moves
+
+# Offsets of a knight and a queen, for isInCheck on the list-of-lists board
+KNIGHT_MOVES = Knight('w').moves
+QUEEN_MOVES = Queen('w').moves
+
+# Parallel root search (AIMove with a rootSearch): each root move is searched by a process of a multiprocessing
+# pool, so the search is not held to one core by the GIL. Positions travel as Mailbox.compact() tuples, and the
+# best root score so far is shared so every root move after the first is searched with a narrower window.
+# The pool lives in a manager's server process, so one pool serves every game of the bot, and the games
+# themselves may run in daemonic processes (which may not start a pool of their own)
+class RootSearchService(object):
+    # processes: size of the pool. searches: most searches at once (ie. concurrent games), each of which gets
+    # processes // searches of the pool's processes, so games searching together do not starve one another
+    def __init__(self, processes, searches):
+        self.share = max(1, processes // searches)
+        self.alphas = multiprocessing.Array('i', searches)    # best root score of each running search
+        self.slots = queue.Queue()    # indices of alphas not used by a running search
+        for slot in range(searches):
+            self.slots.put(slot)
+        self.pool = multiprocessing.Pool(processes, initRootWorker, (self.alphas,))
+
+    # Searches every root move, the first alone. Returns [(move, score or None if the time ran out)]
+    def searchRoot(self, state, moves, depth, deadline, searchId):
+        slot = self.slots.get()
+        try:
+            self.alphas[slot] = -MATE_SCORE - 1
+            tasks = [(state, move, depth, deadline, searchId, slot) for move in moves]
+            results = [self.pool.apply(searchRootMove, tasks[0])]
+            window = threading.Semaphore(self.share)    # root moves of this search being searched
+            pending = []
+            for task in tasks[1:]:
+                window.acquire()
+                pending += [self.pool.apply_async(searchRootMove, task, callback = lambda result: window.release(),
+                                                  error_callback = lambda error: window.release())]
+            return results + [result.get() for result in pending]
+        finally:
+            self.slots.put(slot)
+
+    def close(self):
+        self.pool.terminate()
+        self.pool.join()
+
+class RootSearchManager(multiprocessing.managers.BaseManager):
+    pass
+
+RootSearchManager.register("RootSearchService", RootSearchService)
+
+rootSearchManager = None
+
+# Starts the pool's manager and returns a proxy to its RootSearchService, which may be passed to other processes
+def startRootSearch(processes, searches):
+    global rootSearchManager
+    rootSearchManager = RootSearchManager()
+    rootSearchManager.start()
+    return rootSearchManager.RootSearchService(processes, searches)
+
+# Terminates the pool and its manager
+def stopRootSearch(rootSearch):
+    global rootSearchManager
+    rootSearch.close()
+    rootSearchManager.shutdown()
+    rootSearchManager = None
+
+rootAlphas = None    # in each process of the pool: the RootSearchService's alphas
+
+# Runs in each process of the pool when it starts
+def initRootWorker(alphas):
+    global rootAlphas
+    rootAlphas = alphas
+
+workerSearchId = None    # in each process of the pool: AIMove workerTranspositions belongs to
+workerTranspositions = {}
+
+# Runs in a process of the pool: returns (move, score for the side to move at the root), or (move, None) if
+# the time ran out
+def searchRootMove(state, move, depth, deadline, searchId, slot):
+    global workerSearchId, workerTranspositions
+    if workerSearchId != searchId:    # new AIMove: forget the previous one's transpositions
+        workerTranspositions = {}
+        workerSearchId = searchId
+    position = Mailbox.fromCompact(state)
+    position.makeMove(move)
+    try:
+        score = -ChessEngine.negamax(position, -MATE_SCORE - 1, -rootAlphas[slot], depth - 1, 1, deadline,
+                                     workerTranspositions)[0]
+    except SearchTimeout:
+        return (move, None)
+    with rootAlphas.get_lock():
+        if score > rootAlphas[slot]: rootAlphas[slot] = score
+    return (move, score)
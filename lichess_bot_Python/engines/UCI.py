@@ -87,6 +87,6 @@ def command(depth: int, board: chess.Board, msg: str):
 
 def get_depth() -> int:
     parser = argparse.ArgumentParser()
-    parser.add_argument("--depth", default=3, help="provide an integer (default: 3)")
+    parser.add_argument("--depth", default=5, help="provide an integer (default: 5)")
     args = parser.parse_args()
     return max([1, int(args.depth)])
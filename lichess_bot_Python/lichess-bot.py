@@ -122,6 +122,10 @@ def start(li, user_profile, engine_factory, config, logging_level, log_filename)
     logging_listener = multiprocessing.Process(target=logging_listener_proc, args=(logging_queue, listener_configurer, logging_level, log_filename))
     logging_listener.start()
 
+    root_search = engine_wrapper.start_root_search(config, max_games)
+    if root_search is not None:
+        engine_factory = partial(engine_factory, root_search=root_search)
+
     with logging_pool.LoggingPool(max_games + 1) as pool:
         while not terminated:
             try:
@@ -214,6 +218,8 @@ def start(li, user_profile, engine_factory, config, logging_level, log_filename)
     correspondence_pinger.join()
     logging_listener.terminate()
     logging_listener.join()
+    if root_search is not None:
+        engine_wrapper.stop_root_search(config, root_search)
 
 
 @backoff.on_exception(backoff.expo, BaseException, max_time=600, giveup=is_final)
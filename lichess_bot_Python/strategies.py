@@ -6,6 +6,7 @@ And some handy classes to extend
 import chess
 from chess.engine import PlayResult
 import random
+import os
 from engine_wrapper import EngineWrapper
 from main_CLI import *
 
@@ -116,15 +117,29 @@ class FirstMove(ExampleEngine):
         return PlayResult(moves[0], None)
 
 class CaspersMiniMax(ExampleEngine):
-    """Minimax with depth three"""
+    """Alpha-beta with iterative deepening to depth five, root moves split over a process pool shared by all games"""
+
+    def __init__(self, commands, options, stderr, root_search=None):
+        super().__init__(commands, options, stderr)
+        self.root_search = root_search  # RootSearchService proxy from start_root_search, or None to search serially
+
+    @staticmethod
+    def start_root_search(options, concurrency):
+        """Starts the pool every game's search shares: one process per core, or homemade_options Processes"""
+        processes = int(options.get("Processes", os.cpu_count() or 1))
+        return startRootSearch(processes, concurrency) if processes > 1 else None
+
+    @staticmethod
+    def stop_root_search(root_search):
+        stopRootSearch(root_search)
 
     def search(self, board, *args):
         bool2color = {True: 'w', False: 'b'}
-        depth = 3
+        depth = 5
         # print(f"AI color: {board.turn}")
         board_engineFormat, color = makeBoardFromFen(board.fen())
         # print("Made it here")
-        engine_move = ChessEngine.AIMove(board_engineFormat, color, depth, True)
+        engine_move = ChessEngine.AIMove(board_engineFormat, color, depth, True, rootSearch=self.root_search)
         # print(f"Engine move: {engine_move}")
         UCI_move = translate_engine_to_UCI(board_engineFormat, *engine_move)
         print(f"Move: {UCI_move}")
@@ -160,7 +160,7 @@ def start():
             ChessEngine.specialRules(board, *engine_move[2:4], False, engine_move[4])
         else:
             print("AI is thinking... \n")
-            ChessEngine.AIMove(board, colorToMove, 3)  # Depth of three for now
+            ChessEngine.CEngineMove(board, colorToMove, 5)  # C engine; depth five in the Python fallback
 
         gameOver = ChessEngine.checkGameState(board, whiteToMove)
         whiteToMove = not whiteToMove
@@ -9,10 +9,59 @@
 
 from cmu_112_graphics import *
 import time
+import threading
+import queue
 
 # Below file contains functions + attributes that reinforces chess rules, as well as chess AI
 from ChessEngine import *
 
+# Search depth of each AI difficulty (1: easy, 2: medium, 3: hard)
+AIDepths = {1: 1, 2: 4, 3: 5}
+
+# Runs AI searches on a background thread, so the window keeps redrawing while the AI thinks.
+# timerFired starts a search, then polls for its move; resetting or leaving the game cancels it
+class AIWorker(object):
+    thinking = object()    # returned by poll while the search is still running
+
+    def __init__(self):
+        self.results = queue.Queue()    # (searchId, move) from finished searches
+        self.searchId = 0
+        self.stop = None    # threading.Event of the running search, None when idle
+
+    def busy(self):
+        return self.stop != None
+
+    def start(self, board, color, difficulty):
+        self.cancel()
+        self.searchId += 1
+        self.stop = threading.Event()
+        board = [row[:] for row in board]    # the game may change its board while this searches
+        thread = threading.Thread(target = AIWorker.search, daemon = True,
+                                  args = (self.results, self.searchId, self.stop, board, color, difficulty))
+        thread.start()
+
+    @staticmethod
+    def search(results, searchId, stop, board, color, difficulty):
+        if difficulty == 1:    # Easy stays on the Python engine, which only looks one move ahead
+            move = ChessEngine.AIMove(board, color, AIDepths[difficulty], True, stop = stop)
+        else:
+            move = ChessEngine.CEngineMove(board, color, AIDepths[difficulty], True, stop = stop)
+        results.put((searchId, move))
+
+    # Returns the move of the running search once it is done (None if there are no moves), else thinking
+    def poll(self):
+        while not self.results.empty():
+            (searchId, move) = self.results.get_nowait()
+            if searchId == self.searchId and self.stop != None:    # moves of cancelled searches are dropped
+                self.stop = None
+                return move
+        return AIWorker.thinking
+
+    def cancel(self):
+        if self.stop != None:
+            self.stop.set()
+            self.stop = None
+
 class NormalChessGame(Mode):
     # Makes a chess board with default starting pieces
     def makeBoard(self):
@@ -54,6 +103,7 @@ class NormalChessGame(Mode):
     def __init__(self, AIDifficulty):
         super().__init__()
         self.AIDifficulty = AIDifficulty
+        self.AIWorker = AIWorker()
 
     # Stores app variables
     def appStarted(self):
@@ -68,7 +118,8 @@ class NormalChessGame(Mode):
         self.selectedPiece = None   # (row, col)
         self.whiteToMove = True
         self.pawnPromotion = None
-        self.timerDelay = 1000   # AI checking if it is his turn yet
+        self.timerDelay = 100   # AI checking if it is his turn yet, or if his move is ready
+        self.AIWorker.cancel()    # on reset, forget the search of the previous game
         self.cheated = False    # Player cannot just turn on AI after winning to improve leaderboard
     
     # Function is taken from https://www.cs.cmu.edu/~112/notes/notes-animations-part1.html
@@ -140,6 +191,7 @@ class NormalChessGame(Mode):
     def keyPressed(self, event):
         if event.key in 'aA':    # toggle AI on and off
             self.cheated = True
+            self.AIWorker.cancel()
             if self.AIDifficulty == None:
                 self.AIDifficulty = 1
             else:
@@ -161,7 +213,9 @@ class NormalChessGame(Mode):
             self.app.setActiveMode(self.app.TitlePage)
         elif event.key in 'hH':
             self.app.setActiveMode(self.app.HelpScreen1)
-        elif event.key == '1':    # check black in 1 move
+        elif event.key in '12345':    # debugging boards below replace the board the AI is thinking about
+            self.AIWorker.cancel()
+        if event.key == '1':    # check black in 1 move
             self.board = self.makeBoard()
             self.checkCondition()
             self.whiteToMove = True
@@ -205,12 +259,30 @@ class NormalChessGame(Mode):
             self.whiteToMove = False
 
     def timerFired(self):
-        if self.AIDifficulty != None and not self.whiteToMove:
+        if self.AIDifficulty == None or self.whiteToMove:
+            return
+        if not self.AIWorker.busy():
             print("AI is thinking...")
-            passed = time.time()
-            ChessEngine.AIMove(self.board, 'b', self.AIDifficulty)
-            self.whiteToMove = not self.whiteToMove
-            print("...AI has moved", time.time() - passed)
+            self.AIStarted = time.time()
+            self.AIWorker.start(self.board, 'b', self.AIDifficulty)
+            return
+        move = self.AIWorker.poll()
+        if move is AIWorker.thinking:
+            return
+        if move != None:
+            (row, col, nextRow, nextCol) = move[:4]
+            promotePiece = move[4] if len(move) == 5 else None    # only CEngineMove under-promotes
+            self.board[nextRow][nextCol] = self.board[row][col]
+            self.board[row][col] = None
+            # Check rules & game status (ie. checkmates), as ChessEngine.AIMove does
+            ChessEngine.specialRules(self.board, nextRow, nextCol, promotePiece == None, promotePiece)
+            ChessEngine.checkGameState(self.board, False)
+        self.whiteToMove = not self.whiteToMove
+        print("...AI has moved", time.time() - self.AIStarted)
+
+    # Cancels the AI's search when leaving the game (ie. for the title or help screen)
+    def modeDeactivated(self):
+        self.AIWorker.cancel()
 
     # Draws header on top: title & status of game (ie. check)
     def drawHeader(self, canvas):
@@ -520,7 +592,7 @@ class AIDifficultyScreen(TitlePage):
                                 fill = 'black', outline = 'white')
         canvas.create_text(self.width / 2, self.cy[2], text = '¡Hard!', font = font2, fill = 'white')
         if self.difficulty != None:
-            s = f"Kosbie thinks {self.difficulty} moves ahead"
+            s = f"Kosbie thinks {AIDepths[self.difficulty]} moves ahead"
             canvas.create_text(self.width / 2, self.cy[3], text = s, font = font3, fill = 'white')
     
     def mousePressed(self, event):